@@ -0,0 +1,69 @@
+#pragma once
+
+#include "pool_options.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
+
+namespace taskete
+{
+    enum class scheduling_mode : std::uint8_t
+    {
+        // Ready nodes are dispatched in the order their predecessors released them
+        fifo,
+        // Ready nodes with the longest path to the end of their graph are dispatched first,
+        // among the nodes of each worker, which thieves take from the highest priority too
+        critical_path
+    };
+
+    struct elastic_options
+    {
+        // When disabled the pool keeps executor_options::worker_count workers
+        bool enabled = false;
+        // The pool starts with this many workers, and never goes below it
+        std::uint32_t min_workers = 1;
+        // The pool never goes above this many workers, 0 means one per hardware thread
+        std::uint32_t max_workers = 0;
+        // Ready nodes per running worker above which the queues are considered too deep
+        std::uint32_t grow_threshold = 16;
+        // How long the queues have to stay too deep before a worker is spawned
+        std::chrono::milliseconds grow_after{ 5 };
+        // How long a worker has to stay idle before it retires
+        std::chrono::milliseconds retire_after{ 1000 };
+    };
+
+    struct executor_options
+    {
+        // How many workers will be spawned, 0 means one per hardware thread
+        std::uint32_t worker_count = 0;
+        // How many ready nodes each worker's queue can hold
+        std::uint32_t queue_capacity = 1024;
+        // Options of the pool that holds the nodes
+        pool_options node_pool{ 1024, std::uint32_t(-1), std::pmr::get_default_resource() };
+        // Options of the pool that holds the runtime state of the submitted graphs
+        pool_options graph_pool{ 64, std::uint32_t(-1), std::pmr::get_default_resource() };
+        // How the ready nodes are prioritized
+        scheduling_mode scheduling = scheduling_mode::fifo;
+        // Drops the edges implied by other paths, where a graph declares them
+        bool reduce_edges = false;
+        // Runs each chain of nodes as a single node, where a link is a node with one successor that has no other predecessor
+        bool fuse_chains = false;
+        // How many nodes of graphs with a deadline a worker runs in a row, before it gives a chance to the other nodes
+        std::uint32_t deadline_burst = 16;
+        // How long a node with an affinity hint waits for its worker, before the thieves can take it
+        std::chrono::microseconds affinity_grace{ 100 };
+        // Granularity of the delayed nodes and of the periodic submissions
+        std::chrono::microseconds timer_resolution{ 1000 };
+        // Entries of the io_uring instance shared by the I/O nodes, created with the first graph that has one (Linux only)
+        std::uint32_t io_queue_depth = 256;
+        // Limits the workers a graph can occupy to its share of the pool, weighted among the active graphs
+        bool fair_share = false;
+        // Spawns and retires workers as the load changes, instead of keeping worker_count of them
+        elastic_options elastic{};
+        // Binds each worker to a CPU, and makes it steal from the workers sharing its caches and socket first (Linux only)
+        bool pin_workers = false;
+        // Which resource will be used to manage the workers' queues
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    };
+}
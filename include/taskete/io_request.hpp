@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace taskete
+{
+    enum class io_op : std::uint8_t
+    {
+        read,
+        write,
+        // Flushes the file's data and metadata, buffer/size/offset are ignored
+        fsync,
+        // Flushes only what's needed to read the data back, buffer/size/offset are ignored
+        fdatasync
+    };
+
+    struct io_request
+    {
+        io_op op = io_op::read;
+        // File descriptor, it must stay open until the request completes
+        int fd = -1;
+        // Where the data is read into or written from, it must outlive the request
+        void* buffer = nullptr;
+        std::uint32_t size = 0;
+        std::uint64_t offset = 0;
+        // Set before the node's successors are released: bytes transferred, or -errno
+        std::int32_t result = 0;
+    };
+}
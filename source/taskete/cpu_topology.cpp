@@ -0,0 +1,196 @@
+#include "cpu_topology.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace
+{
+    // First line of a sysfs file, empty if it can't be read
+    std::string read_line(std::string const& path)
+    {
+        std::ifstream file{ path };
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    bool parse_number(std::string_view text, std::uint32_t& value) noexcept
+    {
+        if (text.empty())
+            return false;
+
+        std::uint32_t result = 0;
+        for (auto c : text)
+        {
+            if (c < '0' || c > '9')
+                return false;
+            result = result * 10 + std::uint32_t(c - '0');
+        }
+
+        value = result;
+        return true;
+    }
+}
+
+taskete::detail::cpu_topology::cpu_topology(std::pmr::memory_resource* res)
+    : cpus(res)
+{}
+
+taskete::detail::cpu_topology taskete::detail::cpu_topology::discover(std::pmr::memory_resource* res, std::string const& root)
+{
+    cpu_topology topology{ res };
+
+    auto online = parse_cpu_list(read_line(root + "/online"), res);
+    topology.cpus.reserve(online.size());
+
+    for (auto id : online)
+    {
+        auto cpu_dir = root + "/cpu" + std::to_string(id);
+        cpu_info info{ id, id, id, 0 };
+
+        // Some platforms report -1 when they don't know, it's fine to leave those on socket 0
+        parse_number(read_line(cpu_dir + "/topology/physical_package_id"), info.package);
+
+        // index0, index1, ... until one is missing
+        std::uint32_t llc_level = 0;
+        for (std::uint32_t index = 0; ; ++index)
+        {
+            auto cache_dir = cpu_dir + "/cache/index" + std::to_string(index);
+
+            std::uint32_t level = 0;
+            if (!parse_number(read_line(cache_dir + "/level"), level))
+                break;
+
+            if (read_line(cache_dir + "/type") == "Instruction")
+                continue;
+
+            auto shared = parse_cpu_list(read_line(cache_dir + "/shared_cpu_list"), res);
+            if (shared.empty())
+                continue;
+
+            auto group = *std::min_element(shared.begin(), shared.end());
+            if (level == 2)
+                info.l2 = group;
+            if (level >= llc_level)
+            {
+                llc_level = level;
+                info.llc = group;
+            }
+        }
+
+        topology.cpus.push_back(info);
+    }
+
+    return topology;
+}
+
+std::pmr::vector<std::uint32_t> taskete::detail::cpu_topology::parse_cpu_list(std::string_view list, std::pmr::memory_resource* res)
+{
+    std::pmr::vector<std::uint32_t> result(res);
+
+    while (!list.empty())
+    {
+        auto comma = list.find(',');
+        auto range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+        std::uint32_t first = 0;
+        std::uint32_t last = 0;
+        auto dash = range.find('-');
+        bool valid = dash == std::string_view::npos
+            ? parse_number(range, first) && parse_number(range, last)
+            : parse_number(range.substr(0, dash), first) && parse_number(range.substr(dash + 1), last) && first <= last;
+
+        // Malformed, we can't trust any of it
+        if (!valid)
+        {
+            result.clear();
+            break;
+        }
+
+        for (auto cpu = first; cpu <= last; ++cpu)
+            result.push_back(cpu);
+    }
+
+    return result;
+}
+
+/*
+ * The kernel already narrows the mask to the cpuset of the container.
+ * It's a fixed-size set: on machines with more than CPU_SETSIZE CPUs the call fails and nothing is filtered.
+ */
+std::pmr::vector<std::uint32_t> taskete::detail::cpu_topology::allowed_cpus(std::pmr::memory_resource* res)
+{
+    std::pmr::vector<std::uint32_t> result(res);
+
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return result;
+
+    for (std::uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        if (CPU_ISSET(cpu, &set))
+            result.push_back(cpu);
+#endif
+
+    return result;
+}
+
+void taskete::detail::cpu_topology::retain(std::pmr::vector<std::uint32_t> const& allowed)
+{
+    if (allowed.empty())
+        return;
+
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&allowed](cpu_info const& info)
+    {
+        return std::find(allowed.begin(), allowed.end(), info.id) == allowed.end();
+    }), cpus.end());
+}
+
+taskete::detail::cpu_topology::distance taskete::detail::cpu_topology::distance_between(cpu_info const& a, cpu_info const& b) const noexcept
+{
+    if (a.l2 == b.l2)
+        return same_l2;
+    if (a.llc == b.llc)
+        return same_llc;
+    if (a.package == b.package)
+        return same_package;
+    return remote;
+}
+
+taskete::detail::cpu_info const& taskete::detail::cpu_topology::operator[](std::uint32_t index) const noexcept
+{
+    return cpus[index];
+}
+
+std::uint32_t taskete::detail::cpu_topology::size() const noexcept
+{
+    return std::uint32_t(cpus.size());
+}
+
+bool taskete::detail::cpu_topology::empty() const noexcept
+{
+    return cpus.empty();
+}
+
+bool taskete::detail::pin_current_thread(std::uint32_t cpu) noexcept
+{
+#if defined(__linux__)
+    if (cpu >= CPU_SETSIZE)
+        return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "macro_utils.hpp"
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace taskete::detail
+{
+    /*
+     * Where a logical CPU sits in the machine.
+     * Each group is identified by the lowest CPU that belongs to it.
+     */
+    struct cpu_info
+    {
+        std::uint32_t id;
+        std::uint32_t l2;      // CPUs sharing the same L2 cache
+        std::uint32_t llc;     // CPUs sharing the same last level cache
+        std::uint32_t package; // CPUs on the same socket
+    };
+
+    /*
+     * Caches and sockets of the online CPUs, as described by Linux's sysfs.
+     * Elsewhere, or when sysfs can't be read, every CPU looks like it shares everything with the others.
+     */
+    class TASKETE_LIB_SYMBOLS cpu_topology
+    {
+    private:
+        std::pmr::vector<cpu_info> cpus;
+
+    public:
+        // How far apart 2 CPUs are, stealing is cheaper between close ones
+        enum distance : std::uint32_t
+        {
+            same_l2,
+            same_llc,
+            same_package,
+            remote,
+
+            distance_count
+        };
+
+        explicit cpu_topology(std::pmr::memory_resource* res);
+
+        /*
+         * Reads <root>/online, then <root>/cpuN/topology and <root>/cpuN/cache of each online CPU.
+         */
+        static cpu_topology discover(std::pmr::memory_resource* res, std::string const& root = "/sys/devices/system/cpu");
+
+        // Parses a sysfs CPU list, like "0-3,8,10-11"
+        static std::pmr::vector<std::uint32_t> parse_cpu_list(std::string_view list, std::pmr::memory_resource* res);
+
+        // CPUs the calling thread may run on, as restricted by its affinity mask or its cgroup's cpuset. Empty when unknown
+        static std::pmr::vector<std::uint32_t> allowed_cpus(std::pmr::memory_resource* res);
+
+        // Drops the CPUs that aren't in the list, unless it's empty
+        void retain(std::pmr::vector<std::uint32_t> const& allowed);
+
+        distance distance_between(cpu_info const& a, cpu_info const& b) const noexcept;
+
+        cpu_info const& operator[](std::uint32_t index) const noexcept;
+
+        std::uint32_t size() const noexcept;
+        bool empty() const noexcept;
+    };
+
+    // Binds the calling thread to a single CPU, returns false when it's not supported or it failed
+    TASKETE_LIB_SYMBOLS bool pin_current_thread(std::uint32_t cpu) noexcept;
+}
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace taskete::detail
 {
@@ -39,4 +44,136 @@ namespace taskete::detail
             return sizeof(*this);
         }
     };
+
+    /*
+     * Payload of a condition node, it remembers which branch its callable picked.
+     */
+    class condition_payload : public virtual execution_payload
+    {
+    public:
+        std::uint32_t choice = 0;
+    };
+
+    template<typename Callable, typename... Args>
+    class condition_callable final : public condition_payload
+    {
+    private:
+        Callable c;
+        std::tuple<Args...> params;
+
+    public:
+        condition_callable(Callable&& c, Args&&... args) : c(std::forward<Callable>(c)), params(std::forward<Args>(args)...)
+        {}
+
+        void operator()() noexcept override
+        {
+            choice = static_cast<std::uint32_t>(std::apply(c, params));
+        }
+
+        std::size_t size_of() const noexcept override
+        {
+            return sizeof(*this);
+        }
+    };
+
+    /*
+     * Executes the payloads of a chain of nodes back to back, and owns them:
+     * they are released through the resource of the list.
+     * Stops at the first payload that starts once the graph is cancelled.
+     *
+     * The executor runs the chain with run(): it stops after a member that spawned children,
+     * and the next call goes on from the following member, once the children completed.
+     */
+    class fused_payload final : public virtual execution_payload
+    {
+    private:
+        std::pmr::vector<execution_payload*> members;
+        std::atomic<bool> const* cancelled;
+        std::size_t resume_at = 0; // where the next call starts, past 0 only while the chain waits for children
+
+    public:
+        fused_payload(std::pmr::vector<execution_payload*>&& members, std::atomic<bool> const* cancelled) noexcept
+            : members(std::move(members)), cancelled(cancelled)
+        {}
+
+        fused_payload(fused_payload const&) = delete;
+
+        void operator()() noexcept override
+        {
+            bool never = false;
+            run(never);
+        }
+
+        // 'spawned' is set by the members' spawns, returns true once the whole chain ran
+        bool run(bool const& spawned) noexcept
+        {
+            for (auto i = resume_at; i < members.size(); ++i)
+            {
+                if (cancelled->load(std::memory_order_relaxed))
+                    break;
+
+                (*members[i])();
+
+                if (spawned && i + 1 < members.size())
+                {
+                    resume_at = i + 1;
+                    return false;
+                }
+            }
+
+            resume_at = 0;
+            return true;
+        }
+
+        // The chain stopped at a member that spawned
+        bool suspended() const noexcept
+        {
+            return resume_at != 0;
+        }
+
+        // The rest of the chain is skipped
+        void rewind() noexcept
+        {
+            resume_at = 0;
+        }
+
+        std::size_t size_of() const noexcept override
+        {
+            return sizeof(*this);
+        }
+
+        ~fused_payload() override
+        {
+            auto* res = members.get_allocator().resource();
+            for (auto* member : members)
+            {
+                auto member_size = member->size_of();
+                member->~execution_payload();
+                res->deallocate(member, member_size);
+            }
+        }
+    };
+
+    /*
+     * Allocates and constructs a payload through the given resource.
+     * The payload must be released with node::destroy, that uses size_of() to deallocate it.
+     */
+    template<typename Callable, typename... Args>
+    execution_payload* make_payload(std::pmr::memory_resource* res, Callable&& c, Args&&... args)
+    {
+        using payload_t = universal_callable<Callable, Args...>;
+
+        void* mem = res->allocate(sizeof(payload_t));
+        return new(mem) payload_t(std::forward<Callable>(c), std::forward<Args>(args)...);
+    }
+
+    // Like make_payload, for the callables that return the branch to take
+    template<typename Callable, typename... Args>
+    condition_payload* make_condition(std::pmr::memory_resource* res, Callable&& c, Args&&... args)
+    {
+        using payload_t = condition_callable<Callable, Args...>;
+
+        void* mem = res->allocate(sizeof(payload_t));
+        return new(mem) payload_t(std::forward<Callable>(c), std::forward<Args>(args)...);
+    }
 }
\ No newline at end of file
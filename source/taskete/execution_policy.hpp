@@ -0,0 +1,205 @@
+#pragma once
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace taskete
+{
+    // Elements per sub-range of the algorithms of a policy, unless it says otherwise
+    constexpr std::size_t default_policy_grain = 1024;
+
+    /// <summary>
+    /// Runs the algorithms of this header on the workers of an executor, instead of a thread pool of their own.
+    /// The caller executes nodes too while it waits. Made by taskete::par, it only refers to the executor, that must outlive it.
+    /// </summary>
+    class parallel_policy
+    {
+        executor* owner;
+        std::size_t chunk;
+
+    public:
+        explicit parallel_policy(executor& exec, std::size_t grain = default_policy_grain) noexcept : owner(&exec), chunk(std::max<std::size_t>(grain, 1))
+        {}
+
+        /// <summary>
+        /// Copy of this policy with another grain: sub-ranges are at most this long, and the ranges shorter than twice this aren't split.
+        /// </summary>
+        parallel_policy with_grain(std::size_t grain) const noexcept
+        {
+            return parallel_policy{ *owner, grain };
+        }
+
+        executor& get_executor() const noexcept
+        {
+            return *owner;
+        }
+
+        std::size_t grain() const noexcept
+        {
+            return chunk;
+        }
+    };
+
+    namespace detail
+    {
+        struct parallel_policy_factory
+        {
+            parallel_policy operator()(executor& exec) const noexcept
+            {
+                return parallel_policy{ exec };
+            }
+        };
+
+        // Iterators whose ranges can be split by index, the others run serially
+        template<typename... Its>
+        constexpr bool random_access_v = (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Its>::iterator_category> && ...);
+
+        /*
+         * std::reduce has no identity, only an init that appears once:
+         * each sub-range starts empty and folds from its first element.
+         */
+        template<typename T, typename It, typename BinaryOp, typename Transform>
+        T reduce_blocks(parallel_policy const& policy, It first, It last, T init, BinaryOp& op, Transform& transform)
+        {
+            auto size = std::size_t(last - first);
+            auto partial = parallel_reduce(policy.get_executor(), blocked_range<std::size_t>{ 0, size }, policy.grain(), std::optional<T>{},
+                [first, &op, &transform](std::size_t begin, std::size_t end, std::optional<T> acc)
+                {
+                    for (auto i = begin; i < end; ++i)
+                    {
+                        if (acc)
+                            acc = op(std::move(*acc), transform(first[std::ptrdiff_t(i)]));
+                        else
+                            acc.emplace(transform(first[std::ptrdiff_t(i)]));
+                    }
+                    return acc;
+                },
+                [&op](std::optional<T> lhs, std::optional<T> const& rhs)
+                {
+                    if (!lhs || !rhs)
+                        return lhs ? lhs : rhs;
+                    return std::optional<T>{ op(std::move(*lhs), *rhs) };
+                });
+
+            return partial ? op(std::move(init), std::move(*partial)) : init;
+        }
+    }
+
+    /// <summary>
+    /// taskete::par(exec) makes the policy that runs an algorithm of this header on exec's workers.
+    /// </summary>
+    inline constexpr detail::parallel_policy_factory par{};
+
+    /// <summary>
+    /// Like std::for_each with std::execution::par, split like parallel_for. fn is called concurrently.
+    /// Iterators that aren't random-access are walked serially.
+    /// </summary>
+    template<typename It, typename Fn>
+    void for_each(parallel_policy const& policy, It first, It last, Fn fn)
+    {
+        if constexpr (detail::random_access_v<It>)
+        {
+            auto size = std::size_t(last - first);
+            parallel_for(policy.get_executor(), blocked_range<std::size_t>{ 0, size }, policy.grain(), [first, &fn](std::size_t begin, std::size_t end)
+            {
+                std::for_each(first + std::ptrdiff_t(begin), first + std::ptrdiff_t(end), fn);
+            });
+        }
+        else
+            std::for_each(first, last, fn);
+    }
+
+    /// <summary>
+    /// Like std::transform with std::execution::par, split like parallel_for. op is called concurrently.
+    /// </summary>
+    /// <returns>Past the last element written.</returns>
+    template<typename It, typename OutputIt, typename UnaryOp>
+    OutputIt transform(parallel_policy const& policy, It first, It last, OutputIt d_first, UnaryOp op)
+    {
+        if constexpr (detail::random_access_v<It, OutputIt>)
+        {
+            auto size = std::size_t(last - first);
+            parallel_for(policy.get_executor(), blocked_range<std::size_t>{ 0, size }, policy.grain(), [first, d_first, &op](std::size_t begin, std::size_t end)
+            {
+                std::transform(first + std::ptrdiff_t(begin), first + std::ptrdiff_t(end), d_first + std::ptrdiff_t(begin), op);
+            });
+            return d_first + std::ptrdiff_t(size);
+        }
+        else
+            return std::transform(first, last, d_first, op);
+    }
+
+    /// <summary>
+    /// Like the binary std::transform with std::execution::par, split like parallel_for. op is called concurrently.
+    /// </summary>
+    /// <returns>Past the last element written.</returns>
+    template<typename It1, typename It2, typename OutputIt, typename BinaryOp>
+    OutputIt transform(parallel_policy const& policy, It1 first1, It1 last1, It2 first2, OutputIt d_first, BinaryOp op)
+    {
+        if constexpr (detail::random_access_v<It1, It2, OutputIt>)
+        {
+            auto size = std::size_t(last1 - first1);
+            parallel_for(policy.get_executor(), blocked_range<std::size_t>{ 0, size }, policy.grain(), [first1, first2, d_first, &op](std::size_t begin, std::size_t end)
+            {
+                auto offset = std::ptrdiff_t(begin);
+                std::transform(first1 + offset, first1 + std::ptrdiff_t(end), first2 + offset, d_first + offset, op);
+            });
+            return d_first + std::ptrdiff_t(size);
+        }
+        else
+            return std::transform(first1, last1, first2, d_first, op);
+    }
+
+    /// <summary>
+    /// Like std::reduce with std::execution::par: op must be associative and commutative, init is used once.
+    /// </summary>
+    template<typename It, typename T, typename BinaryOp>
+    T reduce(parallel_policy const& policy, It first, It last, T init, BinaryOp op)
+    {
+        if constexpr (detail::random_access_v<It>)
+        {
+            auto identity = [](auto const& value) -> decltype(auto) { return value; };
+            return detail::reduce_blocks(policy, first, last, std::move(init), op, identity);
+        }
+        else
+            return std::reduce(first, last, std::move(init), op);
+    }
+
+    /// <summary>
+    /// Sum of the range, starting from a value-initialized element.
+    /// </summary>
+    template<typename It>
+    typename std::iterator_traits<It>::value_type reduce(parallel_policy const& policy, It first, It last)
+    {
+        return taskete::reduce(policy, first, last, typename std::iterator_traits<It>::value_type{}, std::plus<>{});
+    }
+
+    /// <summary>
+    /// Like std::transform_reduce with std::execution::par: transform is applied once per element, then the results are reduced like reduce.
+    /// </summary>
+    template<typename It, typename T, typename BinaryOp, typename UnaryOp>
+    T transform_reduce(parallel_policy const& policy, It first, It last, T init, BinaryOp reduce_op, UnaryOp transform_op)
+    {
+        if constexpr (detail::random_access_v<It>)
+            return detail::reduce_blocks(policy, first, last, std::move(init), reduce_op, transform_op);
+        else
+            return std::transform_reduce(first, last, std::move(init), reduce_op, transform_op);
+    }
+
+    /// <summary>
+    /// Like std::sort with std::execution::par, it's parallel_sort.
+    /// </summary>
+    template<typename RandomIt, typename Compare = std::less<>>
+    void sort(parallel_policy const& policy, RandomIt first, RandomIt last, Compare comp = Compare{})
+    {
+        parallel_sort(policy.get_executor(), first, last, std::move(comp), std::max(policy.grain(), default_sort_cutoff));
+    }
+}
@@ -0,0 +1,2266 @@
+#include "executor.hpp"
+#include "graph.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace
+{
+    // Worker running on the current thread, nullptr outside the pool
+    thread_local taskete::detail::worker* tls_worker = nullptr;
+    // Executor that owns tls_worker
+    thread_local taskete::executor* tls_executor = nullptr;
+
+    // The node whose payload is running on a thread, the one that spawns the children
+    struct running_node
+    {
+        taskete::executor const* owner;
+        taskete::handle_t handle;
+        bool has_children;
+    };
+
+    // Innermost running node, a payload that waits for a graph runs other nodes on top of it
+    thread_local running_node* tls_running = nullptr;
+
+    // How many nodes a worker runs, or an external thread pushes, between 2 samples of the queues' depth
+    constexpr std::uint32_t sample_period = 16;
+
+    // How many I/O completions the completion thread handles at once
+    constexpr std::uint32_t io_batch = 64;
+
+    // Tells the periodic tasks from the delayed nodes in the timing wheel, both are identified by a handle
+    constexpr std::uint64_t periodic_tag = std::uint64_t(1) << 32;
+
+    // Heap order: the earliest deadline on top, and the highest priority among the nodes with the same deadline
+    bool later_deadline(taskete::detail::deadline_node const& lhs, taskete::detail::deadline_node const& rhs) noexcept
+    {
+        return lhs.deadline != rhs.deadline ? lhs.deadline > rhs.deadline : lhs.priority < rhs.priority;
+    }
+
+    // Heap order of the prioritized nodes: the highest priority on top
+    bool lower_priority(taskete::detail::ready_node const& lhs, taskete::detail::ready_node const& rhs) noexcept
+    {
+        return lhs.priority < rhs.priority;
+    }
+
+    // xorshift32, good enough to pick a victim
+    std::uint32_t next_random(std::uint32_t& state) noexcept
+    {
+        auto x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return state = x;
+    }
+}
+
+taskete::executor::executor(executor_options options)
+    : options(options)
+    , node_pool(options.node_pool)
+    , graph_pool(options.graph_pool)
+    , workers(options.resource)
+    , stop_requested(false)
+    , next_inbox(0)
+    , outstanding(0)
+    , active_shares(0)
+    , sharing(options.resource)
+    , graph_waiters(0)
+    , active_workers(0)
+    , pressure_since(0)
+    , pressure_ticks(0)
+    , deadline_heap(options.resource)
+    , deadline_count(0)
+    , earliest_deadline(detail::no_deadline)
+    , io_ready(false)
+    , timers(options.resource, timer_tick(std::chrono::steady_clock::now()))
+    , timer_wake_at(detail::timing_wheel::no_expiry)
+    , periodic_pool(options.graph_pool)
+{
+    auto hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    auto count = options.worker_count ? options.worker_count : hardware;
+    auto initial = count;
+    if (options.elastic.enabled)
+    {
+        count = std::max({ 1u, options.elastic.min_workers, options.elastic.max_workers ? options.elastic.max_workers : hardware });
+        initial = std::clamp(options.elastic.min_workers, 1u, count);
+    }
+
+    // Every worker exists from the start, so thieves can look at them without any synchronization
+    workers.reserve(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+        workers.emplace_back(new detail::worker(options.resource, i, options.queue_capacity));
+
+    // The heaps never grow, nothing is allocated under their lock
+    if (options.scheduling == scheduling_mode::critical_path)
+        for (auto* w : workers)
+            w->prioritized.reserve(options.queue_capacity);
+
+    if (options.pin_workers)
+    {
+        // A worker pinned outside of our mask would fail to pin, and run anywhere
+        auto topology = detail::cpu_topology::discover(options.resource);
+        topology.retain(detail::cpu_topology::allowed_cpus(options.resource));
+        assign_steal_domains(topology);
+    }
+    else
+        assign_steal_domains(detail::cpu_topology{ options.resource });
+
+    active_workers.store(initial, std::memory_order_relaxed);
+    for (std::uint32_t i = 0; i < initial; ++i)
+        start_worker(*workers[i]);
+}
+
+taskete::executor::~executor()
+{
+    // A periodic run can't start anymore, the ones already running might still delay their nodes
+    {
+        std::unique_lock lock{ timer_lock };
+        periodic_stop = true;
+    }
+
+    wait_idle();
+
+    // Only the periodic tasks are left in the wheel
+    if (timer_thread.joinable())
+    {
+        {
+            std::unique_lock lock{ timer_lock };
+            timer_stop = true;
+        }
+        timer_wakeup.notify_one();
+        timer_thread.join();
+    }
+
+    std::pmr::vector<std::uint64_t> leftovers(options.resource);
+    timers.drain(leftovers);
+    for (auto data : leftovers)
+        destroy_periodic(handle_t(data));
+
+    // Every request completed, the completion thread is only waiting for the ring:
+    // if the ring refuses the stop, the thread sees it at the end of its current wait
+    if (io_thread.joinable())
+    {
+        io.stop();
+        io_thread.join();
+    }
+
+    {
+        std::unique_lock lock{ elastic_lock }; // nobody can spawn a worker anymore
+        stop_requested.store(true, std::memory_order_release);
+    }
+    parking.notify_all();
+
+    for (auto* w : workers)
+        if (w->thread.joinable())
+            w->thread.join();
+
+    // Only now, thieves might still be looking at any worker until they stop
+    for (auto* w : workers)
+        delete w;
+}
+
+void taskete::executor::destroy_node(handle_t handle) noexcept
+{
+    node_pool.get(handle).destroy(options.node_pool.resource);
+    node_pool.destroy(handle);
+}
+
+taskete::detail::node& taskete::executor::get_node(handle_t handle) noexcept
+{
+    return node_pool.get(handle);
+}
+
+void taskete::executor::submit(handle_t handle) noexcept
+{
+    mark_ready(graph_of(node_pool.get(handle)));
+    push(handle);
+}
+
+void taskete::executor::submit(graph& g)
+{
+    check_dependencies(g);
+
+    if (g.submitted())
+    {
+        restart(g);
+        return;
+    }
+
+    if (!g.size())
+        return;
+
+    auto order = g.topological_order();
+    auto* res = options.node_pool.resource;
+
+    for (graph::node_id id = 0; id < g.size(); ++id)
+    {
+        auto follows = g.infos[id].follows;
+        if (follows == detail::no_predecessor)
+            continue;
+
+        auto& successors = g.infos[graph::node_id(follows)].successors;
+        if (std::find(successors.begin(), successors.end(), id) == successors.end())
+            throw std::logic_error{ "taskete::graph node follows a node that doesn't precede it" };
+    }
+
+    // After the follows are checked, a followed predecessor may reach its node only through a longer path now
+    if (options.reduce_edges)
+        g.reduce_edges(order);
+
+    // Before anything is created, the loops are checked on the edges that are left
+    std::pmr::vector<std::pmr::vector<bool>> loop_bodies(res);
+    for (graph::node_id id = 0; id < g.size(); ++id)
+        for (auto& branch : g.infos[id].branches)
+            if (branch.loop)
+                loop_bodies.push_back(g.loop_body(branch.target, id, order));
+
+    if (std::any_of(g.infos.begin(), g.infos.end(), [](graph::node_info const& info) { return info.io != nullptr; }))
+        start_io_thread();
+    if (std::any_of(g.infos.begin(), g.infos.end(), [](graph::node_info const& info) { return info.delay != 0; }))
+        start_timer_thread();
+
+    bool limited = g.worker_cap || options.fair_share;
+    auto state_handle = graph_pool.construct(options.graph_pool.resource, limited, g.worker_cap, g.worker_share);
+    auto graph_id = std::int32_t(state_handle);
+
+    // Without fusion every node is a chain of its own
+    auto next = options.fuse_chains ? g.chain_links() : std::pmr::vector<std::int64_t>(g.size(), detail::no_predecessor, res);
+    std::pmr::vector<bool> linked(g.size(), false, res); // not the first of its chain
+    for (auto link : next)
+        if (link != detail::no_predecessor)
+            linked[std::size_t(link)] = true;
+
+    std::pmr::vector<handle_t> handles(g.size(), res); // of the node materialized for each chain, for every member
+    std::pmr::vector<handle_t> nodes(res);
+    std::pmr::vector<std::uint64_t> bottom_level(g.size(), res);
+    std::pmr::vector<handle_t> successors(res);
+    std::pmr::vector<detail::execution_payload*> members(res);
+
+    // Backwards, so the successors' handles already exist: they start chains that come after the whole chain
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+    {
+        if (linked[*it])
+            continue;
+
+        auto& info = g.infos[*it];
+
+        auto last = *it;
+        std::uint64_t weight = info.weight;
+        members.assign(1, info.payload);
+        while (next[last] != detail::no_predecessor)
+        {
+            last = graph::node_id(next[last]);
+            weight += g.infos[last].weight;
+            members.push_back(g.infos[last].payload);
+        }
+
+        std::uint64_t longest_path = 0;
+        successors.clear();
+        for (auto successor : g.infos[last].successors)
+        {
+            successors.push_back(handles[successor]);
+            longest_path = std::max(longest_path, bottom_level[successor]);
+        }
+        bottom_level[*it] = weight + longest_path;
+
+        auto* payload = members.front();
+        detail::fused_payload* fused = nullptr;
+        if (members.size() > 1)
+        {
+            void* mem = res->allocate(sizeof(detail::fused_payload));
+            payload = fused = new(mem) detail::fused_payload(std::pmr::vector<detail::execution_payload*>(members, res), &graph_pool.get(state_handle).cancelled);
+        }
+
+        auto handle = node_pool.construct(res, graph_id, info.predecessors, payload, successors.data(), std::uint32_t(successors.size()));
+        nodes.push_back(handle);
+        for (auto member = std::int64_t(*it); member != detail::no_predecessor; member = next[std::size_t(member)])
+            handles[std::size_t(member)] = handle;
+
+        auto& node = node_pool.get(handle);
+        node.fused = fused;
+        node.priority = std::uint32_t(std::min<std::uint64_t>(bottom_level[*it], std::numeric_limits<std::uint32_t>::max()));
+        node.preferred_worker = info.preferred_worker;
+        node.io = info.io;
+        node.delay = info.delay;
+
+        // A member's dependents wait for the whole chain
+        for (auto member = std::int64_t(*it); member != detail::no_predecessor; member = next[std::size_t(member)])
+        {
+            g.infos[std::size_t(member)].handle = handle;
+            node.watched = node.watched || g.infos[std::size_t(member)].watched;
+        }
+    }
+
+    // Predecessors come later in the backwards pass, their handles exist only now
+    for (graph::node_id id = 0; id < g.size(); ++id)
+        if (g.infos[id].follows != detail::no_predecessor && !linked[id])
+            node_pool.get(handles[id]).follows = std::int64_t(handles[graph::node_id(g.infos[id].follows)]);
+
+    // Conditions are never fused, their successors are in the same order in the wait list
+    auto body = loop_bodies.begin();
+    std::pmr::vector<std::int64_t> inside(g.size(), res);
+    for (graph::node_id id = 0; id < g.size(); ++id)
+    {
+        auto& info = g.infos[id];
+        if (!info.condition)
+            continue;
+
+        auto& table = g.branch_tables.emplace_back(res, info.condition);
+        for (auto& branch : info.branches)
+        {
+            if (!branch.loop)
+            {
+                auto index = std::find(info.successors.begin(), info.successors.end(), branch.target) - info.successors.begin();
+                table.branches.push_back(std::int32_t(index));
+                continue;
+            }
+
+            // Each node of the body waits only for its predecessors inside the body, in the next iterations
+            std::fill(inside.begin(), inside.end(), 0);
+            for (graph::node_id member = 0; member < g.size(); ++member)
+                if ((*body)[member])
+                    for (auto successor : g.infos[member].successors)
+                        inside[successor] += (*body)[successor];
+
+            detail::loop_region region{ handles[branch.target], std::pmr::vector<detail::counter_reset>(res) };
+            for (graph::node_id member = 0; member < g.size(); ++member)
+                if ((*body)[member] && !linked[member])
+                    region.resets.push_back({ handles[member], inside[member] });
+
+            table.branches.push_back(-std::int32_t(table.loops.size()) - 1);
+            table.loops.push_back(std::move(region));
+            ++body;
+        }
+
+        node_pool.get(handles[id]).branching = &table;
+    }
+
+    // Kahn's algorithm puts the roots first
+    for (auto id : order)
+    {
+        if (g.infos[id].predecessors)
+            break;
+        g.roots.push_back(handles[id]);
+    }
+
+    g.handles = std::move(nodes);
+    g.state = state_handle;
+
+    start(g);
+}
+
+/*
+ * A graph that completed runs again on the same nodes: only the counters are reset, nothing is allocated.
+ * Once done is set nobody touches the graph's nodes or state anymore.
+ */
+void taskete::executor::restart(graph& g)
+{
+    auto& state = graph_pool.get(g.state);
+    if (!state.done.load(std::memory_order_acquire))
+        throw std::logic_error{ "taskete::graph can be submitted again only once it completed" };
+
+    for (auto h : g.handles)
+    {
+        auto& node = node_pool.get(h);
+        node.wait_counter.store(node.wait_count, std::memory_order_relaxed);
+        node.wait_start = node.wait_count;
+    }
+
+    state.done.store(false, std::memory_order_relaxed);
+
+    start(g);
+}
+
+/*
+ * Opens a new run for the graphs that start after this one, then launches it,
+ * or holds it until the graphs it starts after resolve its gates.
+ */
+void taskete::executor::start(graph& g)
+{
+    auto& state = graph_pool.get(g.state);
+
+    {
+        std::unique_lock lock{ state.dependents_lock };
+        ++state.run;
+        state.finished = false;
+    }
+
+    // Before it's held: a cancel while it waits for the other graphs goes to the state, and must stick
+    state.cancelled.store(std::exchange(g.cancel_requested, false), std::memory_order_relaxed);
+
+    if (g.dependencies.empty())
+    {
+        launch(g);
+        return;
+    }
+
+    state.held = &g;
+    state.gates.store(std::int32_t(g.dependencies.size()) + 1, std::memory_order_relaxed);
+
+    // A held graph keeps the executor busy, until it's launched
+    outstanding.fetch_add(1, std::memory_order_acq_rel);
+
+    std::int32_t resolved = 1;
+    for (auto& dependency : g.dependencies)
+        resolved += watch(*dependency.other, dependency.node, g.state);
+
+    if (resolve(state, resolved))
+        launch_held(state);
+}
+
+void taskete::executor::check_dependencies(graph const& g) const
+{
+    for (auto& dependency : g.dependencies)
+        if (&dependency.other->owner != this || dependency.other == &g || (dependency.other->size() && !dependency.other->submitted()))
+            throw std::logic_error{ "taskete::graph can only start after another graph of the same executor, submitted before it" };
+}
+
+/*
+ * Registers a graph among the dependents of the run of another graph, or of one of its nodes.
+ * A node that wasn't watched when it was materialized can't tell us when it completes, the graph will.
+ * Returns 1 when there's nothing to wait for.
+ */
+std::int32_t taskete::executor::watch(graph const& other, std::int64_t node, handle_t dependent)
+{
+    if (!other.submitted())
+        return 1;
+
+    auto& state = graph_pool.get(other.state);
+    std::unique_lock lock{ state.dependents_lock };
+
+    if (state.finished)
+        return 1;
+
+    auto waited = detail::whole_graph;
+    if (node != detail::whole_graph)
+    {
+        auto handle = other.infos[std::size_t(node)].handle;
+        auto& target = node_pool.get(handle);
+        if (target.watched)
+        {
+            if (target.completed_run == state.run)
+                return 1;
+            waited = std::int64_t(handle);
+        }
+    }
+
+    state.dependents.push_back({ waited, dependent });
+    return 0;
+}
+
+bool taskete::executor::resolve(detail::graph_state& state, std::int32_t count) noexcept
+{
+    return state.gates.fetch_sub(count, std::memory_order_acq_rel) == count;
+}
+
+/*
+ * Launching can run nodes inline, so it never happens under the dependents_lock of the graph that resolved us:
+ * the states are linked through next_held while the lock is taken, and launched once it's released.
+ */
+void taskete::executor::launch_held(detail::graph_state& state) noexcept
+{
+    for (auto* held = &state; held;)
+    {
+        auto* next = std::exchange(held->next_held, nullptr);
+
+        // The roots are accounted for before we drop our reference
+        launch(*held->held);
+        outstanding.fetch_sub(1, std::memory_order_acq_rel);
+
+        held = next;
+    }
+}
+
+/*
+ * A watched node completed: the graphs waiting for it can start, the ones that come later won't wait in this run.
+ */
+void taskete::executor::notify_dependents(detail::graph_state& state, handle_t handle) noexcept
+{
+    detail::graph_state* launched = nullptr;
+
+    {
+        std::unique_lock lock{ state.dependents_lock };
+
+        node_pool.get(handle).completed_run = state.run;
+
+        auto ready = std::partition(state.dependents.begin(), state.dependents.end(), [handle](detail::graph_dependent const& dependent)
+        {
+            return dependent.node != std::int64_t(handle);
+        });
+
+        for (auto it = ready; it != state.dependents.end(); ++it)
+        {
+            auto& dependent = graph_pool.get(it->state);
+            if (resolve(dependent, 1))
+                dependent.next_held = std::exchange(launched, &dependent);
+        }
+
+        state.dependents.erase(ready, state.dependents.end());
+    }
+
+    if (launched)
+        launch_held(*launched);
+}
+
+/*
+ * Takes the graph's current settings, then dispatches its roots.
+ * The counters are published by the pushes.
+ */
+void taskete::executor::launch(graph& g)
+{
+    auto* res = options.node_pool.resource;
+    auto& state = graph_pool.get(g.state);
+
+    state.deadline = g.due;
+    state.limited = g.worker_cap || options.fair_share;
+    state.max_workers = g.worker_cap;
+    state.share = g.worker_share;
+
+    std::pmr::vector<detail::ready_node> roots(res);
+    roots.reserve(g.roots.size());
+    for (auto h : g.roots)
+        roots.push_back({ node_pool.get(h).priority, h });
+
+    if (options.scheduling == scheduling_mode::critical_path)
+    {
+        // Our own heap takes them by increasing priority, the inboxes are FIFO
+        bool lifo = on_worker();
+        std::sort(roots.begin(), roots.end(), [lifo](detail::ready_node const& lhs, detail::ready_node const& rhs)
+        {
+            return lifo ? lhs.priority < rhs.priority : lhs.priority > rhs.priority;
+        });
+    }
+
+    // Every root must be accounted for before any of them can complete
+    state.pending.store(std::int64_t(roots.size()), std::memory_order_release);
+    outstanding.fetch_add(std::int64_t(roots.size()), std::memory_order_acq_rel);
+    if (options.fair_share)
+    {
+        std::unique_lock lock{ sharing_lock };
+        sharing.push_back(&state);
+        active_shares.fetch_add(state.share, std::memory_order_relaxed);
+    }
+
+    // The delayed roots go to the timing wheel, the ones that asked for a worker go straight to it
+    roots.erase(std::remove_if(roots.begin(), roots.end(), [this](detail::ready_node const& root)
+    {
+        auto& node = node_pool.get(root.handle);
+        if (delay_ready(root.handle, node))
+            return true;
+
+        auto* target = preferred_worker(node);
+        if (target)
+            push_affine(*target, root.handle);
+        return target != nullptr;
+    }), roots.end());
+
+    if (roots.empty())
+        return;
+
+    if (state.deadline != detail::no_deadline)
+    {
+        std::pmr::vector<detail::deadline_node> urgent_roots(res);
+        urgent_roots.reserve(roots.size());
+        for (auto& root : roots)
+            urgent_roots.push_back({ state.deadline, root.priority, root.handle });
+
+        push_deadline(urgent_roots.data(), std::uint32_t(urgent_roots.size()));
+        return;
+    }
+
+    std::pmr::vector<handle_t> root_handles(res);
+    root_handles.reserve(roots.size());
+    for (auto& root : roots)
+        root_handles.push_back(root.handle);
+
+    push_bulk(root_handles.data(), std::uint32_t(root_handles.size()));
+}
+
+/*
+ * From outside the pool we join it as a guest until the graph completes.
+ * The guest's queues are never used, but they can't be empty, so they get the smallest capacity.
+ */
+void taskete::executor::wait(graph& g) noexcept
+{
+    if (!g.submitted())
+        return;
+
+    auto& state = graph_pool.get(g.state);
+
+    if (on_worker())
+    {
+        help_until_done(*tls_worker, state);
+        return;
+    }
+
+    detail::worker guest(options.resource, std::uint32_t(workers.size()), 1);
+    guest.guest = true;
+    guest.victims.assign(workers.begin(), workers.end());
+    guest.domains.push_back(std::uint32_t(workers.size()));
+
+    // We might be a worker of another executor
+    auto* previous_worker = tls_worker;
+    auto* previous_executor = tls_executor;
+    tls_worker = &guest;
+    tls_executor = this;
+
+    help_until_done(guest, state);
+
+    tls_worker = previous_worker;
+    tls_executor = previous_executor;
+}
+
+void taskete::executor::wait_idle() noexcept
+{
+    while (outstanding.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+std::uint32_t taskete::executor::worker_count() const noexcept
+{
+    return active_workers.load(std::memory_order_relaxed);
+}
+
+void taskete::executor::start_worker(detail::worker& w)
+{
+    // A retired worker's thread might still be on its way out
+    if (w.thread.joinable())
+        w.thread.join();
+
+    w.running.store(true, std::memory_order_release);
+    w.thread = std::thread{ &executor::worker_loop, this, std::ref(w) };
+}
+
+/*
+ * Starts the first worker that isn't running, if we are below the maximum.
+ */
+bool taskete::executor::spawn_worker() noexcept
+{
+    std::unique_lock lock{ elastic_lock };
+
+    if (stop_requested.load(std::memory_order_acquire) || active_workers.load(std::memory_order_relaxed) == workers.size())
+        return false;
+
+    for (auto* w : workers)
+    {
+        if (w->running.load(std::memory_order_relaxed))
+            continue;
+
+        try
+        {
+            start_worker(*w);
+        }
+        catch (std::system_error const&)
+        {
+            w->running.store(false, std::memory_order_release);
+            return false; // the system is out of threads, let's keep what we have
+        }
+
+        active_workers.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Succeeds only if we are above the minimum.
+ * Our own queue is empty, as we were idle, but a node might still land in our inbox:
+ * pushers skip the retired workers, but they might have looked before we retired.
+ * Thieves visit the retired workers too, so those nodes aren't lost.
+ */
+bool taskete::executor::retire(detail::worker& self) noexcept
+{
+    {
+        std::unique_lock lock{ elastic_lock };
+
+        if (stop_requested.load(std::memory_order_acquire) || active_workers.load(std::memory_order_relaxed) <= std::max(1u, options.elastic.min_workers))
+            return false;
+
+        self.running.store(false, std::memory_order_release);
+        active_workers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Hand over what we already received.
+    // Not through push_external(), it could try to spawn a worker, and the spawner might be waiting for us to exit.
+    handle_t handle{};
+    while (true)
+    {
+        {
+            std::unique_lock lock{ self.inbox_consumer };
+            if (!self.inbox.try_pull(handle))
+                break;
+        }
+
+        while (!try_push_external(handle))
+            std::this_thread::yield();
+        parking.notify_one();
+    }
+
+    return true;
+}
+
+/*
+ * Spawns a worker once the queues stayed too deep for options.elastic.grow_after,
+ * and nobody is idle: a parked worker would pick up the work without any help.
+ */
+void taskete::executor::sample_pressure() noexcept
+{
+    auto active = active_workers.load(std::memory_order_relaxed);
+    if (active == workers.size())
+        return;
+
+    if (parking.waiters() || queue_depth() <= std::uint64_t(active) * options.elastic.grow_threshold)
+    {
+        pressure_since.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto since = pressure_since.load(std::memory_order_relaxed);
+    if (!since)
+    {
+        pressure_since.compare_exchange_strong(since, now, std::memory_order_relaxed, std::memory_order_relaxed);
+        return;
+    }
+
+    auto grow_after = std::chrono::duration_cast<std::chrono::steady_clock::duration>(options.elastic.grow_after).count();
+    if (now - since < grow_after)
+        return;
+
+    // Only one of the threads that noticed it spawns a worker
+    if (pressure_since.compare_exchange_strong(since, 0, std::memory_order_relaxed, std::memory_order_relaxed))
+        spawn_worker();
+}
+
+/*
+ * Ready nodes in every queue, it's only an estimate as the queues keep changing.
+ */
+std::uint64_t taskete::executor::queue_depth() const noexcept
+{
+    std::uint64_t depth = deadline_count.load(std::memory_order_relaxed);
+    for (auto* w : workers)
+        depth += w->local.count() + w->prioritized_count.load(std::memory_order_relaxed) + (w->inbox.size() - w->inbox.free_space()) + w->affine_count.load(std::memory_order_relaxed);
+
+    return depth;
+}
+
+/*
+ * Like worker_loop, but it returns as soon as the graph completes.
+ *
+ * seq_cst on graph_waiters and done pairs with complete():
+ * either we see the graph completed, or it sees us parked and wakes us up.
+ */
+void taskete::executor::help_until_done(detail::worker& self, detail::graph_state const& state) noexcept
+{
+    handle_t handle{};
+    detail::backoff idle;
+
+    while (!state.done.load(std::memory_order_acquire))
+    {
+        if (find_work(self, handle))
+        {
+            run(self, handle);
+            idle.reset();
+            continue;
+        }
+
+        if (idle.spin())
+            continue;
+
+        graph_waiters.fetch_add(1, std::memory_order_seq_cst);
+        auto key = parking.prepare_wait();
+
+        if (state.done.load(std::memory_order_seq_cst))
+            parking.cancel_wait();
+        else if (find_work(self, handle))
+        {
+            parking.cancel_wait();
+            run(self, handle);
+        }
+        else if (any_affine())
+            parking.commit_wait_for(key, options.affinity_grace);
+        else
+            parking.commit_wait(key);
+
+        graph_waiters.fetch_sub(1, std::memory_order_relaxed);
+        idle.reset();
+    }
+}
+
+bool taskete::executor::should_split() const noexcept
+{
+    if (parking.waiters())
+        return true;
+
+    return on_worker() && tls_worker->local.empty() && !tls_worker->prioritized_count.load(std::memory_order_relaxed);
+}
+
+bool taskete::executor::on_worker() const noexcept
+{
+    return tls_executor == this && !tls_worker->guest;
+}
+
+/*
+ * Pins the workers to the CPUs in order, wrapping around if there are more workers than CPUs,
+ * then sorts each worker's victims by how far they are: same L2, same LLC, same socket, remote.
+ *
+ * Without a topology nobody is pinned, and every victim is in the same domain.
+ */
+void taskete::executor::assign_steal_domains(detail::cpu_topology const& topology)
+{
+    using distance = detail::cpu_topology::distance;
+
+    auto count = std::uint32_t(workers.size());
+    if (!topology.empty())
+        for (std::uint32_t i = 0; i < count; ++i)
+            workers[i]->cpu = std::int32_t(topology[i % topology.size()].id);
+
+    auto distance_between = [&topology](detail::worker const& a, detail::worker const& b)
+    {
+        if (topology.empty())
+            return distance::same_l2;
+        return topology.distance_between(topology[a.id % topology.size()], topology[b.id % topology.size()]);
+    };
+
+    for (auto* self : workers)
+    {
+        for (std::uint32_t level = 0; level < distance::distance_count; ++level)
+        {
+            auto domain_begin = self->victims.size();
+
+            for (auto* victim : workers)
+                if (victim != self && distance_between(*self, *victim) == level)
+                    self->victims.push_back(victim);
+
+            if (self->victims.size() != domain_begin)
+                self->domains.push_back(std::uint32_t(self->victims.size()));
+        }
+    }
+}
+
+void taskete::executor::worker_loop(detail::worker& self) noexcept
+{
+    tls_worker = &self;
+    tls_executor = this;
+
+    if (self.cpu >= 0)
+        detail::pin_current_thread(std::uint32_t(self.cpu));
+
+    handle_t handle{};
+    detail::backoff idle;
+
+    while (!stop_requested.load(std::memory_order_acquire))
+    {
+        if (find_work(self, handle))
+        {
+            run(self, handle);
+            idle.reset();
+
+            if (options.elastic.enabled && !(++self.runs % sample_period))
+                sample_pressure();
+            continue;
+        }
+
+        if (idle.spin())
+            continue;
+
+        // Nothing to do for a while, time to sleep.
+        // We look for work once more, a node might have been pushed before we announced ourselves.
+        auto key = parking.prepare_wait();
+        if (stop_requested.load(std::memory_order_acquire))
+        {
+            parking.cancel_wait();
+            break;
+        }
+
+        if (find_work(self, handle))
+        {
+            parking.cancel_wait();
+            run(self, handle);
+        }
+        else if (any_affine()) // we might be woken up instead of their worker, the thieves must be around when they expire
+            parking.commit_wait_for(key, options.affinity_grace);
+        else if (!options.elastic.enabled)
+            parking.commit_wait(key);
+        else if (!parking.commit_wait_for(key, options.elastic.retire_after) && retire(self))
+            break;
+
+        idle.reset();
+    }
+
+    tls_worker = nullptr;
+    tls_executor = nullptr;
+}
+
+/*
+ * Looks for a ready node in this order:
+ * 1. the node with the earliest deadline
+ * 2. the nodes that asked for us
+ * 3. our own queue, newest first, or the highest priority first with scheduling_mode::critical_path
+ * 4. our own inbox
+ * 5. someone else's queue or inbox, oldest first (highest priority first), or the nodes that waited too long for their worker
+ *
+ * After options.deadline_burst nodes with a deadline in a row, we look at 2-5 first once,
+ * so the graphs without a deadline can't starve.
+ */
+bool taskete::executor::find_work(detail::worker& self, handle_t& handle) noexcept
+{
+    if (self.deadline_streak < options.deadline_burst && take_deadline(handle))
+    {
+        ++self.deadline_streak;
+        return true;
+    }
+
+    self.deadline_streak = 0;
+
+    if (take_affine(self, handle))
+        return true;
+
+    if (take_prioritized(self, handle) || self.local.try_pop(handle))
+        return true;
+
+    {
+        std::unique_lock lock{ self.inbox_consumer };
+        if (self.inbox.try_pull(handle))
+            return true;
+    }
+
+    return steal(self, handle) || take_deadline(handle);
+}
+
+/*
+ * Visits every other worker once, one steal domain at a time, the closest first.
+ * Inside a domain we start from a random victim, so the thieves don't all pick the same one.
+ */
+bool taskete::executor::steal(detail::worker& thief, handle_t& handle) noexcept
+{
+    std::uint32_t begin = 0;
+    for (auto end : thief.domains)
+    {
+        auto count = end - begin;
+        auto start = next_random(thief.rng_state) % count;
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            auto& victim = *thief.victims[begin + (start + i) % count];
+
+            if (steal_prioritized(victim, handle) || victim.local.try_steal(handle))
+                return true;
+
+            if (victim.inbox_consumer.try_lock())
+            {
+                bool found = victim.inbox.try_pull(handle);
+                victim.inbox_consumer.unlock();
+                if (found)
+                    return true;
+            }
+
+            if (steal_affine(victim, handle))
+                return true;
+        }
+
+        begin = end;
+    }
+
+    return false;
+}
+
+/*
+ * Only the oldest node can be stolen, and only once its grace period expired.
+ */
+bool taskete::executor::steal_affine(detail::worker& victim, handle_t& handle) noexcept
+{
+    if (!victim.affine_count.load(std::memory_order_acquire) || !victim.affine_lock.try_lock())
+        return false;
+
+    bool found = false;
+    if (!victim.affine.empty() && victim.affine.front().stealable_at <= std::chrono::steady_clock::now().time_since_epoch().count())
+    {
+        handle = victim.affine.front().handle;
+        victim.affine.pop_front();
+        victim.affine_count.fetch_sub(1, std::memory_order_relaxed);
+        found = true;
+    }
+
+    victim.affine_lock.unlock();
+    return found;
+}
+
+bool taskete::executor::take_affine(detail::worker& self, handle_t& handle) noexcept
+{
+    if (!self.affine_count.load(std::memory_order_acquire))
+        return false;
+
+    std::unique_lock lock{ self.affine_lock };
+    if (self.affine.empty())
+        return false;
+
+    handle = self.affine.front().handle;
+    self.affine.pop_front();
+    self.affine_count.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool taskete::executor::any_affine() const noexcept
+{
+    return std::any_of(workers.begin(), workers.end(), [](detail::worker const* w)
+    {
+        return w->affine_count.load(std::memory_order_relaxed) != 0;
+    });
+}
+
+/*
+ * Whether the ready nodes go into the worker's heap instead of its queue.
+ * Nobody steals from a guest, and the nodes of a graph with a deadline go into the deadline heap.
+ */
+bool taskete::executor::prioritize(detail::worker const& self, detail::graph_state const* state) const noexcept
+{
+    return options.scheduling == scheduling_mode::critical_path && !self.guest && !(state && state->deadline != detail::no_deadline);
+}
+
+/*
+ * Returns how many nodes fit, the heap doesn't grow past queue_capacity.
+ * The nodes come by increasing priority and are pushed from the last one, so the highest priorities are the ones that fit.
+ */
+std::uint32_t taskete::executor::push_prioritized(detail::worker& self, detail::ready_node const* nodes, std::uint32_t count) noexcept
+{
+    std::uint32_t pushed = 0;
+    {
+        std::unique_lock lock{ self.prioritized_lock };
+        auto room = std::uint32_t(self.prioritized.capacity() - self.prioritized.size());
+        for (; pushed < std::min(count, room); ++pushed)
+        {
+            self.prioritized.push_back(nodes[count - 1 - pushed]);
+            std::push_heap(self.prioritized.begin(), self.prioritized.end(), lower_priority);
+        }
+
+        self.prioritized_count.fetch_add(pushed, std::memory_order_release);
+    }
+
+    if (pushed)
+        parking.notify_many(pushed);
+    return pushed;
+}
+
+bool taskete::executor::take_prioritized(detail::worker& self, handle_t& handle) noexcept
+{
+    if (!self.prioritized_count.load(std::memory_order_acquire))
+        return false;
+
+    std::unique_lock lock{ self.prioritized_lock };
+    if (self.prioritized.empty())
+        return false;
+
+    std::pop_heap(self.prioritized.begin(), self.prioritized.end(), lower_priority);
+    handle = self.prioritized.back().handle;
+    self.prioritized.pop_back();
+    self.prioritized_count.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+bool taskete::executor::steal_prioritized(detail::worker& victim, handle_t& handle) noexcept
+{
+    if (!victim.prioritized_count.load(std::memory_order_acquire) || !victim.prioritized_lock.try_lock())
+        return false;
+
+    bool found = false;
+    if (!victim.prioritized.empty())
+    {
+        std::pop_heap(victim.prioritized.begin(), victim.prioritized.end(), lower_priority);
+        handle = victim.prioritized.back().handle;
+        victim.prioritized.pop_back();
+        victim.prioritized_count.fetch_sub(1, std::memory_order_relaxed);
+        found = true;
+    }
+
+    victim.prioritized_lock.unlock();
+    return found;
+}
+
+/*
+ * The worker that ran the predecessor we follow, otherwise our preferred one.
+ * nullptr when there's no hint, or the worker doesn't exist or isn't running.
+ */
+taskete::detail::worker* taskete::executor::preferred_worker(detail::node const& node) noexcept
+{
+    auto id = node.follows != detail::no_predecessor
+        ? node_pool.get(handle_t(node.follows)).executed_by
+        : node.preferred_worker;
+
+    if (id < 0 || std::uint32_t(id) >= workers.size())
+        return nullptr;
+
+    auto* target = workers[std::size_t(id)];
+    return target->running.load(std::memory_order_relaxed) ? target : nullptr;
+}
+
+void taskete::executor::push_affine(detail::worker& target, handle_t handle) noexcept
+{
+    auto grace = std::chrono::duration_cast<std::chrono::steady_clock::duration>(options.affinity_grace);
+    auto stealable_at = (std::chrono::steady_clock::now() + grace).time_since_epoch().count();
+
+    {
+        std::unique_lock lock{ target.affine_lock };
+        target.affine.push_back({ handle, stealable_at });
+        target.affine_count.fetch_add(1, std::memory_order_release);
+    }
+
+    parking.notify_one();
+}
+
+/*
+ * Executes a node, unless its graph already occupies all the workers it's allowed to.
+ */
+void taskete::executor::run(detail::worker& self, handle_t handle) noexcept
+{
+    auto* state = graph_of(node_pool.get(handle));
+
+    if (state && state->limited && !acquire_slot(*state))
+    {
+        defer(self, *state, handle);
+        return;
+    }
+
+    run_with_slot(self, handle, state);
+}
+
+/*
+ * Executes a node and then, without going through a queue,
+ * one of the successors it made ready, and so on.
+ *
+ * The graph's slot is kept along the chain, and once the chain ends
+ * it's handed over to a node of the same graph that was deferred.
+ */
+void taskete::executor::run_with_slot(detail::worker& self, handle_t handle, detail::graph_state* state) noexcept
+{
+    while (true)
+    {
+        auto& node = node_pool.get(handle);
+
+        node.executed_by = std::int32_t(self.id);
+
+        // A cancelled graph drains without executing anything, but its nodes still release their successors.
+        // So do the nodes that no branch reached, and their successors won't run either.
+        bool dead = node.dead();
+        bool cancelled = state && state->cancelled.load(std::memory_order_relaxed);
+        bool completed = true;
+
+        node.taken = dead ? detail::no_successor : detail::all_successors;
+        node.loop = detail::no_loop;
+
+        if (cancelled || dead)
+        {
+            if (node.io)
+                node.io->result = -ECANCELED;
+            if (node.fused)
+                node.fused->rewind();
+        }
+        else if (node.io && io_ready.load(std::memory_order_acquire))
+        {
+            // The kernel doesn't need our slot, and once the request is submitted the graph might complete at any time
+            handle_t next{};
+            bool has_next = false;
+            if (state && state->limited)
+            {
+                release_slot(*state);
+                has_next = take_deferred(*state, next);
+            }
+
+            start_io(handle, *node.io);
+
+            if (!has_next)
+                return;
+
+            handle = next;
+            continue;
+        }
+        else if (node.io)
+            node.io->result = detail::io_ring::perform(*node.io);
+        else
+        {
+            running_node frame{ this, handle, false };
+            auto* outer = std::exchange(tls_running, &frame);
+            bool chain_done = true;
+            if (node.fused)
+                chain_done = node.fused->run(frame.has_children);
+            else
+                (*node.exec_payload)();
+            tls_running = outer;
+
+            if (node.branching)
+                take_branch(node);
+
+            // Until its last child completes, the node keeps its successors waiting, or the rest of its chain, and the graph pending
+            if (frame.has_children && node.children.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                completed = false;
+            else if (!chain_done)
+                continue; // the children are done already, the chain goes on right away
+        }
+
+        handle_t continuation{};
+        bool has_continuation = completed && complete_node(self, handle, state, continuation);
+
+        if (!has_continuation && state && state->limited)
+        {
+            release_slot(*state);
+            has_continuation = take_deferred(*state, continuation);
+        }
+
+        // The successors have already been accounted for, so we can't reach 0 too early.
+        // Once the graph completes, its state can be destroyed at any time.
+        auto* continuation_state = has_continuation ? state : nullptr;
+        if (completed)
+            finish(state);
+
+        if (!has_continuation)
+            return;
+
+        if (should_yield(continuation_state))
+        {
+            push_ready(self, continuation, continuation_state);
+            return;
+        }
+
+        handle = continuation;
+    }
+}
+
+/*
+ * Without a completion thread the ring is useless, the requests are executed synchronously.
+ */
+void taskete::executor::start_io_thread()
+{
+    std::call_once(io_started, [this]
+    {
+        if (!io.open(options.io_queue_depth))
+            return;
+
+        try
+        {
+            io_thread = std::thread{ &executor::io_loop, this };
+        }
+        catch (std::system_error const&)
+        {
+            return;
+        }
+
+        io_ready.store(true, std::memory_order_release);
+    });
+}
+
+/*
+ * Releases the successors of the I/O nodes as their requests complete.
+ * If the ring breaks down the requests in flight are lost, there's nothing left to wait on.
+ */
+void taskete::executor::io_loop() noexcept
+{
+    std::array<detail::io_completion, io_batch> completions{};
+
+    while (true)
+    {
+        auto count = io.wait(completions.data(), io_batch);
+        if (!count)
+            return;
+
+        bool stop = false;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            if (completions[i].user_data == detail::io_ring::stop_marker)
+                stop = true;
+            else
+                complete_io(handle_t(completions[i].user_data), completions[i].result);
+        }
+
+        if (stop)
+            return;
+    }
+}
+
+/*
+ * When the ring is full, the request is executed right away by the caller.
+ */
+void taskete::executor::start_io(handle_t handle, io_request& request) noexcept
+{
+    if (!io.submit(request, handle))
+        complete_io(handle, detail::io_ring::perform(request));
+}
+
+/*
+ * The completion path of an I/O node: it publishes the result, then releases the successors like a worker would,
+ * from the completion thread they go to the inboxes.
+ */
+void taskete::executor::complete_io(handle_t handle, std::int32_t result) noexcept
+{
+    auto& node = node_pool.get(handle);
+    auto* state = graph_of(node);
+
+    node.io->result = result;
+
+    for (auto successor : node.wait_list)
+    {
+        auto& next = node_pool.get(successor);
+        if (!next.release(true))
+            continue;
+
+        mark_ready(state);
+
+        if (!delay_ready(successor, next))
+            push_released(successor, state);
+    }
+
+    if (state && node.watched)
+        notify_dependents(*state, handle);
+
+    finish(state);
+}
+
+/*
+ * Timer ticks since the clock's epoch, rounded up so that nothing fires early.
+ */
+std::int64_t taskete::executor::timer_tick(std::chrono::steady_clock::time_point when) const noexcept
+{
+    auto resolution = std::max<std::int64_t>(1, std::chrono::duration_cast<std::chrono::steady_clock::duration>(options.timer_resolution).count());
+    auto ticks = when.time_since_epoch().count();
+
+    return ticks / resolution + (ticks % resolution != 0);
+}
+
+void taskete::executor::start_timer_thread()
+{
+    std::call_once(timer_started, [this]
+    {
+        timer_thread = std::thread{ &executor::timer_loop, this };
+    });
+}
+
+/*
+ * Sleeps until the next slot of the wheel that holds something, or until a timer is scheduled before it.
+ * The timers fire without holding the lock, so the workers can keep scheduling.
+ */
+void taskete::executor::timer_loop() noexcept
+{
+    auto resolution = std::max<std::int64_t>(1, std::chrono::duration_cast<std::chrono::steady_clock::duration>(options.timer_resolution).count());
+    std::pmr::vector<std::uint64_t> expired(options.resource);
+
+    std::unique_lock lock{ timer_lock };
+    while (!timer_stop)
+    {
+        // Only the ticks that fully elapsed, the due ones are rounded up
+        timers.advance(std::chrono::steady_clock::now().time_since_epoch().count() / resolution, expired);
+
+        if (!expired.empty())
+        {
+            lock.unlock();
+            for (auto data : expired)
+                fire_timer(data);
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        timer_wake_at = timers.next_expiry();
+        if (timer_wake_at == detail::timing_wheel::no_expiry)
+            timer_wakeup.wait(lock);
+        else
+            timer_wakeup.wait_until(lock, std::chrono::steady_clock::time_point{ std::chrono::steady_clock::duration{ timer_wake_at * resolution } });
+
+        // Awake, whatever is scheduled from now on is seen before we sleep again
+        timer_wake_at = std::numeric_limits<std::int64_t>::min();
+    }
+}
+
+/*
+ * The state's flag is checked under the lock, so cancel_graph() either finds our entry or we see the graph cancelled.
+ */
+bool taskete::executor::schedule_timer(std::int64_t due, std::uint64_t data, detail::graph_state const* state) noexcept
+{
+    bool earlier = false;
+    {
+        std::unique_lock lock{ timer_lock };
+        if (state && state->cancelled.load(std::memory_order_relaxed))
+            return false;
+
+        timers.schedule(due, data);
+        earlier = due < timer_wake_at;
+    }
+
+    if (earlier)
+        timer_wakeup.notify_one();
+
+    return true;
+}
+
+/*
+ * A delayed node that became ready goes to the timing wheel, it's dispatched once it fires.
+ * It's already accounted for, so its graph can't complete meanwhile.
+ * Once its graph is cancelled a node isn't delayed anymore, and cancel_graph() takes the ones already in the wheel out.
+ */
+bool taskete::executor::delay_ready(handle_t handle, detail::node const& node) noexcept
+{
+    // Neither a cancelled graph nor a node that is skipped have anything to wait for
+    auto* state = graph_of(node);
+    if (!node.delay || node.dead() || (state && state->cancelled.load(std::memory_order_relaxed)))
+        return false;
+
+    auto due = std::chrono::steady_clock::now() + std::chrono::steady_clock::duration{ node.delay };
+    return schedule_timer(timer_tick(due), handle, state);
+}
+
+/*
+ * The nodes of the graph waiting in the timing wheel are dispatched right away, they'll be skipped like the others,
+ * so the graph completes as soon as its running nodes end.
+ */
+void taskete::executor::cancel_graph(handle_t state_handle) noexcept
+{
+    auto& state = graph_pool.get(state_handle);
+    state.cancelled.store(true, std::memory_order_relaxed);
+
+    std::pmr::vector<std::uint64_t> released(options.resource);
+    {
+        std::unique_lock lock{ timer_lock };
+        timers.extract_if([this, state_handle](std::uint64_t data)
+        {
+            return !(data & periodic_tag) && handle_t(node_pool.get(handle_t(data)).graph_id) == state_handle;
+        }, released);
+    }
+
+    for (auto data : released)
+        fire_timer(data);
+}
+
+void taskete::executor::fire_timer(std::uint64_t data) noexcept
+{
+    if (data & periodic_tag)
+    {
+        fire_periodic(handle_t(data));
+        return;
+    }
+
+    auto handle = handle_t(data);
+    push_released(handle, graph_of(node_pool.get(handle)));
+}
+
+/*
+ * Launches a run, unless the previous one is still going, and schedules the next one.
+ * A cancelled task is destroyed once its last run ended.
+ *
+ * The run is accounted for under timer_lock, so once the executor sets periodic_stop
+ * every run that started can be waited for.
+ */
+void taskete::executor::fire_periodic(handle_t id) noexcept
+{
+    auto& task = periodic_pool.get(id);
+    bool launch = false;
+
+    {
+        std::unique_lock lock{ timer_lock };
+
+        if (periodic_stop || task.cancelled.load(std::memory_order_acquire))
+        {
+            if (task.busy.load(std::memory_order_acquire))
+            {
+                timers.schedule(timers.current() + 1, periodic_tag | id);
+                return;
+            }
+
+            lock.unlock();
+            destroy_periodic(id);
+            return;
+        }
+
+        if (!task.busy.exchange(true, std::memory_order_acq_rel))
+        {
+            mark_ready(nullptr);
+            launch = true;
+        }
+
+        // Runs that are too late are skipped, not piled up
+        task.next_due = std::max(task.next_due + task.period, timers.current() + 1);
+        timers.schedule(task.next_due, periodic_tag | id);
+    }
+
+    if (!launch)
+        return;
+
+    auto handle = make_node(0, nullptr, 0, [&task]
+    {
+        (*task.payload)();
+        task.busy.store(false, std::memory_order_release);
+    });
+    node_pool.get(handle).transient = true;
+
+    push(handle);
+}
+
+void taskete::executor::destroy_periodic(handle_t id) noexcept
+{
+    auto& task = periodic_pool.get(id);
+
+    auto payload_size = task.payload->size_of();
+    task.payload->~execution_payload();
+    options.node_pool.resource->deallocate(task.payload, payload_size);
+
+    periodic_pool.destroy(id);
+}
+
+taskete::handle_t taskete::executor::start_every(std::chrono::steady_clock::duration period, detail::execution_payload* payload)
+{
+    try
+    {
+        start_timer_thread();
+    }
+    catch (...)
+    {
+        auto payload_size = payload->size_of();
+        payload->~execution_payload();
+        options.node_pool.resource->deallocate(payload, payload_size);
+        throw;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto first_due = timer_tick(now + period);
+    auto ticks = std::max<std::int64_t>(1, first_due - timer_tick(now));
+
+    auto id = periodic_pool.construct(payload, ticks, first_due);
+    schedule_timer(first_due, periodic_tag | id);
+
+    return id;
+}
+
+/*
+ * The callable returns as soon as the graph is submitted, so busy doesn't cover the graph's run: done does.
+ * The task is the only one submitting the graph, once done is seen set it stays so until we submit again.
+ */
+taskete::handle_t taskete::executor::submit_every(std::chrono::steady_clock::duration period, graph& g)
+{
+    return submit_every(period, [this, &g]() noexcept
+    {
+        if (g.submitted() && !graph_pool.get(g.state).done.load(std::memory_order_acquire))
+            return;
+
+        // The payload can't throw, an invalid graph is never run
+        try
+        {
+            submit(g);
+        }
+        catch (std::logic_error const&)
+        {
+        }
+    });
+}
+
+void taskete::executor::cancel_every(handle_t periodic) noexcept
+{
+    periodic_pool.get(periodic).cancelled.store(true, std::memory_order_release);
+}
+
+/*
+ * A node released from outside the workers' loop, by the I/O completion thread, by a timer or by a spawn.
+ */
+void taskete::executor::push_released(handle_t handle, detail::graph_state const* state) noexcept
+{
+    auto& node = node_pool.get(handle);
+
+    if (state && state->deadline != detail::no_deadline && !preferred_worker(node))
+    {
+        detail::deadline_node urgent{ state->deadline, node.priority, handle };
+        push_deadline(&urgent, 1);
+    }
+    else
+        push(handle);
+}
+
+/*
+ * Notifies each successor that we completed, as a dead edge unless we ran and took the branch leading to it.
+ * The first one that becomes ready is returned as our continuation,
+ * the others are pushed into our queue where the thieves can find them.
+ * A successor that asked for another worker is sent to that worker instead.
+ */
+bool taskete::executor::release_successors(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept
+{
+    if (options.scheduling == scheduling_mode::critical_path)
+        return release_by_priority(self, node, state, continuation);
+
+    bool found = false;
+    auto taken = node.taken;
+    std::int32_t index = 0;
+
+    for (auto successor : node.wait_list)
+    {
+        auto& next = node_pool.get(successor);
+        bool live = taken == detail::all_successors || taken == index++;
+        if (!next.release(live))
+            continue;
+
+        mark_ready(state);
+
+        if (delay_ready(successor, next))
+            continue;
+
+        auto* target = preferred_worker(next);
+        if (!found && (!target || target == &self))
+        {
+            continuation = successor;
+            found = true;
+        }
+        else
+            push_ready(self, successor, state);
+    }
+
+    return found;
+}
+
+/*
+ * Like release_successors, but the ready successors are sorted by priority.
+ * They go into our heap with the nodes released before them, and the top is our continuation
+ * when it belongs to our graph: otherwise we return without one, and find_work() picks it.
+ * A guest, or a graph with a deadline, can't use the heap: the highest successor becomes our continuation,
+ * and the others are pushed in increasing order so that they're popped from the highest to the lowest.
+ *
+ * A nested run() (our heap or queue is full) uses the scratch space past our range,
+ * and shrinks it back before returning, so we use indices instead of iterators.
+ */
+bool taskete::executor::release_by_priority(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept
+{
+    auto base = self.ready.size();
+    auto taken = node.taken;
+    std::int32_t index = 0;
+
+    for (auto successor : node.wait_list)
+    {
+        auto& next = node_pool.get(successor);
+        bool live = taken == detail::all_successors || taken == index++;
+        if (!next.release(live))
+            continue;
+
+        mark_ready(state);
+
+        if (delay_ready(successor, next))
+            continue;
+
+        auto* target = preferred_worker(next);
+        if (target && target != &self)
+            push_affine(*target, successor);
+        else
+            self.ready.push_back({ next.priority, successor });
+    }
+
+    auto end = self.ready.size();
+    if (base == end)
+        return false;
+
+    std::sort(self.ready.begin() + std::ptrdiff_t(base), self.ready.end(), lower_priority);
+
+    if (prioritize(self, state))
+    {
+        bool found = false;
+        std::size_t fit = 0;
+        std::size_t added = 0;
+        {
+            std::unique_lock lock{ self.prioritized_lock };
+            auto before = self.prioritized.size();
+
+            // On a tie our own successor goes on, it's where the data is
+            if (self.prioritized.empty() || !lower_priority(self.ready[end - 1], self.prioritized.front()))
+            {
+                continuation = self.ready[--end].handle;
+                found = true;
+            }
+
+            fit = std::min(end - base, self.prioritized.capacity() - before);
+            for (auto i = end - fit; i < end; ++i)
+            {
+                self.prioritized.push_back(self.ready[i]);
+                std::push_heap(self.prioritized.begin(), self.prioritized.end(), lower_priority);
+            }
+
+            // Our slot is only good for our graph
+            if (!found && !self.prioritized.empty() && node_pool.get(self.prioritized.front().handle).graph_id == node.graph_id)
+            {
+                std::pop_heap(self.prioritized.begin(), self.prioritized.end(), lower_priority);
+                continuation = self.prioritized.back().handle;
+                self.prioritized.pop_back();
+                found = true;
+            }
+
+            added = self.prioritized.size() > before ? self.prioritized.size() - before : 0;
+            self.prioritized_count.store(std::uint32_t(self.prioritized.size()), std::memory_order_release);
+        }
+
+        if (added)
+            parking.notify_many(std::uint32_t(added));
+
+        // The lowest ones didn't fit, they run right away as with push_local()
+        for (auto i = base; i < end - fit; ++i)
+            run(self, self.ready[i].handle);
+
+        self.ready.resize(base);
+        return found;
+    }
+
+    continuation = self.ready[end - 1].handle;
+    for (auto i = base; i < end - 1; ++i)
+        push_ready(self, self.ready[i].handle, state);
+
+    self.ready.resize(base);
+
+    return true;
+}
+
+/*
+ * Releases the successors of a node that completed, then joins its parent, if it spawned us.
+ * A parent that was only waiting for us completes as well, so does its own parent and so on:
+ * each of them is finished here, the node itself is finished by the caller.
+ */
+bool taskete::executor::complete_node(detail::worker& self, handle_t handle, detail::graph_state* state, handle_t& continuation) noexcept
+{
+    bool found = release_or_loop(self, node_pool.get(handle), state, continuation);
+    if (state && node_pool.get(handle).watched)
+        notify_dependents(*state, handle);
+
+    while (true)
+    {
+        auto& node = node_pool.get(handle);
+        auto parent = node.parent;
+
+        if (node.transient)
+            destroy_node(handle);
+
+        if (parent == detail::no_parent || node_pool.get(handle_t(parent)).children.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return found;
+
+        // We were the last child, our parent completes now
+        handle = handle_t(parent);
+
+        // Unless it's a chain that stopped at a member that spawned us: it goes on, still pending, with the next member
+        auto& resumed = node_pool.get(handle);
+        if (resumed.fused && resumed.fused->suspended())
+        {
+            auto* worker = preferred_worker(resumed);
+            if (found || (worker && worker != &self))
+                push_ready(self, handle, state);
+            else
+            {
+                continuation = handle;
+                found = true;
+            }
+
+            return found;
+        }
+
+        handle_t next{};
+        bool released = release_or_loop(self, node_pool.get(handle), state, next);
+        if (state && node_pool.get(handle).watched)
+            notify_dependents(*state, handle);
+
+        if (released)
+        {
+            if (found)
+                push_ready(self, next, state);
+            else
+            {
+                continuation = next;
+                found = true;
+            }
+        }
+
+        finish(state);
+    }
+}
+
+/*
+ * Looks up what the branch picked by a condition's payload does.
+ */
+void taskete::executor::take_branch(detail::node& node) noexcept
+{
+    auto& table = *node.branching;
+    auto choice = table.payload->choice;
+
+    if (choice >= table.branches.size())
+        node.taken = detail::no_successor;
+    else if (table.branches[choice] >= 0)
+        node.taken = table.branches[choice];
+    else
+        node.loop = -table.branches[choice] - 1;
+}
+
+bool taskete::executor::release_or_loop(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept
+{
+    if (node.loop == detail::no_loop)
+        return release_successors(self, node, state, continuation);
+
+    return repeat_loop(self, node, state, continuation);
+}
+
+/*
+ * Instead of releasing its successors, the condition runs its loop's body again:
+ * each node of the body waits for its predecessors inside the body, and the first one is our continuation.
+ * The whole body completed before the condition ran, so nobody else touches these counters.
+ */
+bool taskete::executor::repeat_loop(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept
+{
+    auto& region = node.branching->loops[std::size_t(node.loop)];
+
+    for (auto& reset : region.resets)
+    {
+        auto& member = node_pool.get(reset.handle);
+        member.wait_counter.store(reset.value, std::memory_order_relaxed);
+        member.wait_start = std::int32_t(reset.value);
+    }
+
+    mark_ready(state);
+
+    auto& target = node_pool.get(region.target);
+    if (delay_ready(region.target, target))
+        return false;
+
+    auto* worker = preferred_worker(target);
+    if (worker && worker != &self)
+    {
+        push_affine(*worker, region.target);
+        return false;
+    }
+
+    continuation = region.target;
+    return true;
+}
+
+/*
+ * The child takes the running node's graph and priority, and is accounted for like a released successor.
+ * The first child also takes a reference for the running payload, dropped once it returns.
+ * A child that spawns hands its children to its own parent, that it keeps waiting until it completes:
+ * the tree stays flat, so a long chain of spawns doesn't keep a node alive per link.
+ */
+void taskete::executor::spawn_child(detail::execution_payload* payload)
+{
+    auto* res = options.node_pool.resource;
+
+    if (!tls_running || tls_running->owner != this)
+    {
+        auto payload_size = payload->size_of();
+        payload->~execution_payload();
+        res->deallocate(payload, payload_size);
+        throw std::logic_error{ "taskete::executor::spawn must be called by a running node of the same executor" };
+    }
+
+    auto& frame = *tls_running;
+    auto graph_id = node_pool.get(frame.handle).graph_id;
+    auto handle = node_pool.construct(res, graph_id, 0, payload, nullptr, 0u);
+
+    auto& running = node_pool.get(frame.handle);
+    auto& child = node_pool.get(handle);
+    child.transient = true;
+    child.priority = running.priority;
+
+    // The push publishes the counter to the child
+    if (running.transient && running.parent != detail::no_parent)
+    {
+        child.parent = running.parent;
+        node_pool.get(handle_t(running.parent)).children.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        child.parent = std::int64_t(frame.handle);
+        running.children.fetch_add(frame.has_children ? 1 : 2, std::memory_order_relaxed);
+        frame.has_children = true;
+    }
+
+    auto* state = graph_of(running);
+    mark_ready(state);
+    push_released(handle, state);
+}
+
+taskete::detail::graph_state* taskete::executor::graph_of(detail::node const& node) noexcept
+{
+    if (node.graph_id == detail::no_graph)
+        return nullptr;
+
+    return &graph_pool.get(handle_t(node.graph_id));
+}
+
+void taskete::executor::mark_ready(detail::graph_state* state) noexcept
+{
+    outstanding.fetch_add(1, std::memory_order_acq_rel);
+    if (state)
+        state->pending.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void taskete::executor::finish(detail::graph_state* state) noexcept
+{
+    if (state && state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        complete(*state);
+
+    outstanding.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+/*
+ * Once done is set the graph can be destroyed by its waiter, so we can't touch the state anymore.
+ */
+void taskete::executor::complete(detail::graph_state& state) noexcept
+{
+    if (options.fair_share)
+        leave_share(state);
+
+    // Whoever still waits for us, or for a node that didn't tell, can start
+    detail::graph_state* launched = nullptr;
+    {
+        std::unique_lock lock{ state.dependents_lock };
+        state.finished = true;
+        for (auto& d : state.dependents)
+        {
+            auto& dependent = graph_pool.get(d.state);
+            if (resolve(dependent, 1))
+                dependent.next_held = std::exchange(launched, &dependent);
+        }
+        state.dependents.clear();
+    }
+
+    if (launched)
+        launch_held(*launched);
+
+    state.done.store(true, std::memory_order_seq_cst);
+
+    if (graph_waiters.load(std::memory_order_seq_cst))
+        parking.notify_all();
+}
+
+/*
+ * The graph's hard cap, further limited to its share of the workers
+ * when other graphs are running too.
+ */
+std::uint32_t taskete::executor::slot_limit(detail::graph_state const& state) const noexcept
+{
+    std::uint64_t limit = state.max_workers ? state.max_workers : worker_count();
+
+    if (options.fair_share)
+    {
+        auto active = active_shares.load(std::memory_order_relaxed);
+        if (active > state.share)
+            limit = std::min(limit, std::max<std::uint64_t>(1, std::uint64_t(worker_count()) * state.share / active));
+    }
+
+    return std::uint32_t(limit);
+}
+
+/*
+ * seq_cst pairs with take_deferred():
+ * either the worker releasing a slot sees the deferred node,
+ * or the worker deferring it sees the free slot.
+ */
+bool taskete::executor::acquire_slot(detail::graph_state& state) noexcept
+{
+    auto limit = slot_limit(state);
+    auto running = state.running.load(std::memory_order_seq_cst);
+
+    do
+    {
+        if (running >= limit)
+            return false;
+    }
+    while (!state.running.compare_exchange_weak(running, running + 1, std::memory_order_seq_cst, std::memory_order_seq_cst));
+
+    return true;
+}
+
+void taskete::executor::release_slot(detail::graph_state& state) noexcept
+{
+    state.running.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void taskete::executor::defer(detail::worker& self, detail::graph_state& state, handle_t handle) noexcept
+{
+    {
+        std::unique_lock lock{ state.deferred_lock };
+        state.deferred.push_back(handle);
+        state.deferred_count.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    // Every slot might have been released before our node was visible
+    handle_t next{};
+    if (take_deferred(state, next))
+        run_with_slot(self, next, &state);
+}
+
+/*
+ * A graph gives its share back: the others' limits grow, so their deferred nodes are dispatched up to the new limit,
+ * instead of one per completion of their own nodes.
+ * They're pushed once the lock is released, since a push can run a node inline, and they keep their graph pending meanwhile.
+ * A node that finds its graph at the cap anyway is deferred again.
+ */
+void taskete::executor::leave_share(detail::graph_state& state) noexcept
+{
+    std::pmr::vector<std::pair<handle_t, detail::graph_state*>> widened(options.resource);
+
+    {
+        std::unique_lock lock{ sharing_lock };
+        active_shares.fetch_sub(state.share, std::memory_order_relaxed);
+        sharing.erase(std::find(sharing.begin(), sharing.end(), &state));
+
+        for (auto* other : sharing)
+        {
+            if (!other->deferred_count.load(std::memory_order_seq_cst))
+                continue;
+
+            auto limit = slot_limit(*other);
+            auto running = other->running.load(std::memory_order_seq_cst);
+
+            std::unique_lock backlog{ other->deferred_lock };
+            for (; running < limit && !other->deferred.empty(); ++running)
+            {
+                widened.push_back({ other->deferred.front(), other });
+                other->deferred.pop_front();
+                other->deferred_count.fetch_sub(1, std::memory_order_seq_cst);
+            }
+        }
+    }
+
+    for (auto& [handle, other] : widened)
+        push_released(handle, other);
+}
+
+/*
+ * On success, we own a slot of the graph.
+ */
+bool taskete::executor::take_deferred(detail::graph_state& state, handle_t& handle) noexcept
+{
+    while (state.deferred_count.load(std::memory_order_seq_cst))
+    {
+        if (!acquire_slot(state))
+            return false;
+
+        {
+            std::unique_lock lock{ state.deferred_lock };
+            if (!state.deferred.empty())
+            {
+                handle = state.deferred.front();
+                state.deferred.pop_front();
+                state.deferred_count.fetch_sub(1, std::memory_order_seq_cst);
+                return true;
+            }
+        }
+
+        release_slot(state);
+    }
+
+    return false;
+}
+
+void taskete::executor::push(handle_t handle) noexcept
+{
+    if (auto* target = preferred_worker(node_pool.get(handle)))
+        push_affine(*target, handle);
+    else if (on_worker())
+        push_local(*tls_worker, handle);
+    else
+        push_external(handle);
+}
+
+/*
+ * Publishes many ready nodes with a single cursor update per queue, and a single wakeup.
+ *
+ * From a worker they go into its own queue, what doesn't fit goes to the inboxes.
+ * The inboxes get the nodes interleaved, so they keep the order they were given in.
+ */
+void taskete::executor::push_bulk(handle_t const* handles, std::uint32_t count)
+{
+    std::uint32_t pushed = 0;
+    if (on_worker() && prioritize(*tls_worker, nullptr))
+    {
+        std::pmr::vector<detail::ready_node> nodes(options.resource);
+        nodes.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+            nodes.push_back({ node_pool.get(handles[i]).priority, handles[i] });
+
+        // The ones that don't fit are the first ones, the inboxes take them
+        count -= push_prioritized(*tls_worker, nodes.data(), count);
+        if (!count)
+            return;
+    }
+    else if (on_worker())
+        pushed = tls_worker->local.try_push_bulk(handles, count);
+
+    if (pushed < count)
+    {
+        std::pmr::vector<detail::worker*> targets(options.resource);
+        for (auto* w : workers)
+            if (w->running.load(std::memory_order_relaxed))
+                targets.push_back(w);
+
+        auto worker_no = std::uint32_t(targets.size());
+        auto start = next_inbox.fetch_add(1, std::memory_order_relaxed);
+
+        std::pmr::vector<handle_t> batch(options.resource);
+        std::pmr::vector<handle_t> leftovers(options.resource);
+        batch.reserve((count - pushed) / std::max(worker_no, 1u) + 1);
+
+        // The workers were retiring and spawning while we looked
+        if (!worker_no)
+            leftovers.assign(handles + pushed, handles + count);
+
+        for (std::uint32_t i = 0; i < worker_no; ++i)
+        {
+            batch.clear();
+            for (auto n = pushed + i; n < count; n += worker_no)
+                batch.push_back(handles[n]);
+
+            if (batch.empty())
+                break;
+
+            auto& target = *targets[(start + i) % worker_no];
+            std::uint32_t done{};
+            {
+                std::unique_lock lock{ target.inbox_producer };
+                done = target.inbox.try_push_bulk(batch.data(), std::uint32_t(batch.size()));
+            }
+
+            leftovers.insert(leftovers.end(), batch.begin() + done, batch.end());
+        }
+
+        // Wake up the workers before waiting for them to drain the inboxes
+        parking.notify_many(count - std::uint32_t(leftovers.size()));
+
+        // Slow path, the inboxes are full
+        for (auto handle : leftovers)
+        {
+            if (on_worker())
+                push_local(*tls_worker, handle);
+            else
+                push_external(handle);
+        }
+    }
+    else
+        parking.notify_many(count);
+
+    if (options.elastic.enabled && !on_worker())
+        sample_pressure();
+}
+
+/*
+ * If our queue is full there is no point in waiting for it to drain,
+ * we are the only one that can pop from the bottom, so we run the node right away.
+ * Nobody steals from a guest, so its nodes go to the inboxes instead, if there's room.
+ */
+void taskete::executor::push_local(detail::worker& self, handle_t handle) noexcept
+{
+    if (prioritize(self, nullptr))
+    {
+        detail::ready_node node{ node_pool.get(handle).priority, handle };
+        if (!push_prioritized(self, &node, 1))
+            run(self, handle);
+        return;
+    }
+
+    bool pushed = self.guest ? try_push_external(handle) : self.local.try_push(handle);
+
+    if (pushed)
+        parking.notify_one();
+    else
+        run(self, handle);
+}
+
+void taskete::executor::push_ready(detail::worker& self, handle_t handle, detail::graph_state const* state) noexcept
+{
+    if (auto* target = preferred_worker(node_pool.get(handle)))
+        push_affine(*target, handle);
+    else if (state && state->deadline != detail::no_deadline)
+    {
+        detail::deadline_node node{ state->deadline, node_pool.get(handle).priority, handle };
+        push_deadline(&node, 1);
+    }
+    else
+        push_local(self, handle);
+}
+
+void taskete::executor::push_deadline(detail::deadline_node const* nodes, std::uint32_t count) noexcept
+{
+    {
+        std::unique_lock lock{ deadline_lock };
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            deadline_heap.push_back(nodes[i]);
+            std::push_heap(deadline_heap.begin(), deadline_heap.end(), later_deadline);
+        }
+
+        earliest_deadline.store(deadline_heap.front().deadline, std::memory_order_relaxed);
+        deadline_count.fetch_add(count, std::memory_order_release);
+    }
+
+    parking.notify_many(count);
+}
+
+bool taskete::executor::take_deadline(handle_t& handle) noexcept
+{
+    if (!deadline_count.load(std::memory_order_acquire))
+        return false;
+
+    std::unique_lock lock{ deadline_lock };
+    if (deadline_heap.empty())
+        return false;
+
+    std::pop_heap(deadline_heap.begin(), deadline_heap.end(), later_deadline);
+    handle = deadline_heap.back().handle;
+    deadline_heap.pop_back();
+
+    earliest_deadline.store(deadline_heap.empty() ? detail::no_deadline : deadline_heap.front().deadline, std::memory_order_relaxed);
+    deadline_count.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+/*
+ * A chain of nodes gives way to a graph with an earlier deadline.
+ * Not with a concurrency cap, the chain owns one of its graph's slots.
+ */
+bool taskete::executor::should_yield(detail::graph_state const* state) const noexcept
+{
+    if (state && state->limited)
+        return false;
+
+    auto deadline = state ? state->deadline : detail::no_deadline;
+    return deadline_count.load(std::memory_order_relaxed) && earliest_deadline.load(std::memory_order_relaxed) < deadline;
+}
+
+void taskete::executor::push_external(handle_t handle) noexcept
+{
+    while (!try_push_external(handle))
+        std::this_thread::yield();
+
+    parking.notify_one();
+
+    if (options.elastic.enabled && !(pressure_ticks.fetch_add(1, std::memory_order_relaxed) % sample_period))
+        sample_pressure();
+}
+
+/*
+ * Distributes the nodes among the inboxes in round-robin,
+ * skipping the full ones and the ones of the retired workers.
+ */
+bool taskete::executor::try_push_external(handle_t handle) noexcept
+{
+    auto count = std::uint32_t(workers.size());
+    auto start = next_inbox.fetch_add(1, std::memory_order_relaxed);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        auto& target = *workers[(start + i) % count];
+        if (!target.running.load(std::memory_order_relaxed))
+            continue;
+
+        std::unique_lock lock{ target.inbox_producer };
+        if (target.inbox.try_push(handle))
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <taskete/executor_options.hpp>
+#include <taskete/handle.hpp>
+
+#include "macro_utils.hpp"
+#include "cpu_topology.hpp"
+#include "execution_payload.hpp"
+#include "graph_state.hpp"
+#include "io_ring.hpp"
+#include "lock_helpers.hpp"
+#include "lockfree_ringbuffer.hpp"
+#include "node.hpp"
+#include "pool_manager.hpp"
+#include "timing_wheel.hpp"
+#include "work_stealing_deque.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace taskete
+{
+    class graph;
+
+    namespace detail
+    {
+        struct ready_node
+        {
+            std::uint32_t priority;
+            handle_t handle;
+        };
+
+        struct affine_node
+        {
+            handle_t handle;
+            std::int64_t stealable_at; // steady_clock ticks
+        };
+
+        struct deadline_node
+        {
+            std::int64_t deadline;
+            std::uint32_t priority;
+            handle_t handle;
+        };
+
+        /*
+         * A payload executed every period by a transient node.
+         * A run is skipped when the previous one didn't end yet.
+         */
+        struct periodic_task
+        {
+            execution_payload* payload;
+            std::int64_t period;   // timer ticks
+            std::int64_t next_due; // timer tick, only touched by the timer thread
+            std::atomic<bool> busy{ false };
+            std::atomic<bool> cancelled{ false };
+
+            periodic_task(execution_payload* payload, std::int64_t period, std::int64_t next_due)
+                : payload(payload), period(period), next_due(next_due)
+            {}
+        };
+
+        /*
+         * Each worker owns 2 queues of ready nodes:
+         * 1. local, where the worker pushes/pops at one end and the thieves steal from the other one
+         * 2. inbox, where threads outside the pool submit their nodes
+         * and a 3rd one, affine, for the nodes that asked to run on this worker: thieves can take them only once they waited long enough
+         *
+         * With scheduling_mode::critical_path, prioritized replaces local: a heap with the highest priority on top,
+         * for the worker and the thieves alike.
+         *
+         * Thieves visit the other workers one steal domain at a time, the closest first.
+         *
+         * A thread outside the pool that waits for a graph becomes a guest worker until the graph completes:
+         * it can steal like the others, but nobody can steal from it, so it sends its ready nodes to the inboxes.
+         */
+        struct worker
+        {
+            std::uint32_t id;
+            std::uint32_t rng_state;
+            std::int32_t cpu = -1; // where the worker is pinned, -1 if it isn't
+            bool guest = false;
+
+            std::atomic<bool> running{ false }; // false once retired, or before it's spawned
+            std::uint32_t runs = 0;             // to sample the queues' depth every now and then
+            std::uint32_t deadline_streak = 0;  // nodes with a deadline run in a row
+
+            std::pmr::vector<worker*> victims;  // every other worker, the closest first
+            std::pmr::vector<std::uint32_t> domains; // where each steal domain ends inside victims
+
+            work_stealing_deque<handle_t> local;
+
+            spinlock prioritized_lock;
+            std::pmr::vector<ready_node> prioritized; // heap, up to queue_capacity nodes
+            std::atomic<std::uint32_t> prioritized_count{ 0 };
+
+            lockfree_ringbuffer<handle_t> inbox;
+            spinlock inbox_producer; // the ringbuffer supports 1 producer...
+            spinlock inbox_consumer; // ...and 1 consumer at a time
+
+            spinlock affine_lock;
+            std::pmr::deque<affine_node> affine; // oldest first
+            std::atomic<std::uint32_t> affine_count{ 0 };
+
+            std::thread thread;
+
+            // Scratch space to sort the successors by priority, used as a stack by nested releases
+            std::pmr::vector<ready_node> ready;
+
+            worker(std::pmr::memory_resource* res, std::uint32_t id, std::uint32_t queue_capacity)
+                : id(id), rng_state(id * 2654435761u + 1u), victims(res), domains(res), local(res, queue_capacity), prioritized(res), inbox(res, queue_capacity), affine(res), ready(res)
+            {
+                ready.reserve(queue_capacity);
+            }
+        };
+    }
+
+    /// <summary>
+    /// Work-stealing pool of workers that executes ready nodes.
+    ///
+    /// Nodes are constructed inside the executor's node pool and referred by their handle.
+    /// Once a node completes, its successors are released, and the ones that become ready are executed too.
+    /// </summary>
+    class TASKETE_LIB_SYMBOLS executor
+    {
+        friend class graph;
+
+    private:
+        executor_options options;
+        detail::pool_manager<detail::node> node_pool;
+        detail::pool_manager<detail::graph_state> graph_pool;
+        std::pmr::vector<detail::worker*> workers; // every worker that can ever run, only the running ones have a thread
+
+        std::atomic<bool> stop_requested;
+        std::atomic<std::uint32_t> next_inbox;
+        std::atomic<std::int64_t> outstanding; // submitted but not yet executed nodes
+        std::atomic<std::uint64_t> active_shares; // sum of the shares of the graphs still running
+        detail::spinlock sharing_lock;
+        std::pmr::vector<detail::graph_state*> sharing; // graphs counted in active_shares, under sharing_lock
+        std::atomic<std::uint32_t> graph_waiters; // threads parked until a graph completes
+
+        // Elastic pool
+        std::atomic<std::uint32_t> active_workers;
+        std::atomic<std::int64_t> pressure_since; // steady_clock ticks since the queues are too deep, 0 if they aren't
+        std::atomic<std::uint32_t> pressure_ticks; // to sample the queues' depth every now and then from outside the pool
+        std::mutex elastic_lock;                   // serializes spawning, retiring and stopping
+
+        detail::eventcount parking; // where idle workers sleep
+
+        // Ready nodes of the graphs with a deadline, a heap with the earliest on top
+        detail::spinlock deadline_lock;
+        std::pmr::vector<detail::deadline_node> deadline_heap;
+        std::atomic<std::uint32_t> deadline_count;
+        std::atomic<std::int64_t> earliest_deadline;
+
+        // I/O nodes, the ring and its completion thread are created with the first graph that needs them
+        detail::io_ring io;
+        std::once_flag io_started;
+        std::atomic<bool> io_ready;
+        std::thread io_thread;
+
+        // Delayed nodes and periodic submissions, the timer thread is created with the first timer
+        detail::timing_wheel timers;        // guarded by timer_lock, like the flags below
+        std::mutex timer_lock;
+        std::condition_variable timer_wakeup;
+        std::int64_t timer_wake_at;         // tick the timer thread sleeps until, the lowest one while it's awake
+        bool timer_stop = false;
+        bool periodic_stop = false;         // the periodic tasks don't run anymore, the executor is going away
+        std::once_flag timer_started;
+        std::thread timer_thread;
+        detail::pool_manager<detail::periodic_task> periodic_pool;
+
+        void restart(graph& g);
+        void start(graph& g);
+        void launch(graph& g);
+
+        // Dependencies between graphs
+        void check_dependencies(graph const& g) const;
+        std::int32_t watch(graph const& other, std::int64_t node, handle_t dependent);
+        bool resolve(detail::graph_state& state, std::int32_t count) noexcept; // true once the last gate dropped
+        void launch_held(detail::graph_state& state) noexcept;
+        void notify_dependents(detail::graph_state& state, handle_t handle) noexcept;
+
+        void start_io_thread();
+        void io_loop() noexcept;
+        void start_io(handle_t handle, io_request& request) noexcept;
+        void complete_io(handle_t handle, std::int32_t result) noexcept;
+
+        std::int64_t timer_tick(std::chrono::steady_clock::time_point when) const noexcept;
+        void start_timer_thread();
+        void timer_loop() noexcept;
+        bool schedule_timer(std::int64_t due, std::uint64_t data, detail::graph_state const* state = nullptr) noexcept;
+        bool delay_ready(handle_t handle, detail::node const& node) noexcept;
+        void cancel_graph(handle_t state_handle) noexcept;
+        void fire_timer(std::uint64_t data) noexcept;
+        void fire_periodic(handle_t id) noexcept;
+        void destroy_periodic(handle_t id) noexcept;
+        handle_t start_every(std::chrono::steady_clock::duration period, detail::execution_payload* payload);
+
+        void assign_steal_domains(detail::cpu_topology const& topology);
+
+        void start_worker(detail::worker& w);
+        bool spawn_worker() noexcept;
+        bool retire(detail::worker& self) noexcept;
+        void sample_pressure() noexcept;
+        std::uint64_t queue_depth() const noexcept;
+
+        void worker_loop(detail::worker& self) noexcept;
+        bool find_work(detail::worker& self, handle_t& handle) noexcept;
+        bool steal(detail::worker& thief, handle_t& handle) noexcept;
+        bool steal_affine(detail::worker& victim, handle_t& handle) noexcept;
+        bool take_affine(detail::worker& self, handle_t& handle) noexcept;
+        bool any_affine() const noexcept;
+        bool prioritize(detail::worker const& self, detail::graph_state const* state) const noexcept;
+        std::uint32_t push_prioritized(detail::worker& self, detail::ready_node const* nodes, std::uint32_t count) noexcept;
+        bool take_prioritized(detail::worker& self, handle_t& handle) noexcept;
+        bool steal_prioritized(detail::worker& victim, handle_t& handle) noexcept;
+        detail::worker* preferred_worker(detail::node const& node) noexcept;
+        void push_affine(detail::worker& target, handle_t handle) noexcept;
+        void help_until_done(detail::worker& self, detail::graph_state const& state) noexcept;
+        bool on_worker() const noexcept;
+        void run(detail::worker& self, handle_t handle) noexcept;
+        void run_with_slot(detail::worker& self, handle_t handle, detail::graph_state* state) noexcept;
+        bool release_successors(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept;
+        bool release_by_priority(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept;
+        bool complete_node(detail::worker& self, handle_t handle, detail::graph_state* state, handle_t& continuation) noexcept;
+        void take_branch(detail::node& node) noexcept;
+        bool release_or_loop(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept;
+        bool repeat_loop(detail::worker& self, detail::node& node, detail::graph_state* state, handle_t& continuation) noexcept;
+        void spawn_child(detail::execution_payload* payload);
+
+        detail::graph_state* graph_of(detail::node const& node) noexcept;
+        void mark_ready(detail::graph_state* state) noexcept;
+        void finish(detail::graph_state* state) noexcept;
+        void complete(detail::graph_state& state) noexcept;
+
+        std::uint32_t slot_limit(detail::graph_state const& state) const noexcept;
+        bool acquire_slot(detail::graph_state& state) noexcept;
+        void release_slot(detail::graph_state& state) noexcept;
+        void defer(detail::worker& self, detail::graph_state& state, handle_t handle) noexcept;
+        void leave_share(detail::graph_state& state) noexcept;
+        bool take_deferred(detail::graph_state& state, handle_t& handle) noexcept;
+
+        void push(handle_t handle) noexcept;
+        void push_bulk(handle_t const* handles, std::uint32_t count);
+        void push_local(detail::worker& self, handle_t handle) noexcept;
+        void push_ready(detail::worker& self, handle_t handle, detail::graph_state const* state) noexcept;
+        void push_deadline(detail::deadline_node const* nodes, std::uint32_t count) noexcept;
+        bool take_deadline(handle_t& handle) noexcept;
+        bool should_yield(detail::graph_state const* state) const noexcept;
+        void push_external(handle_t handle) noexcept;
+        bool try_push_external(handle_t handle) noexcept;
+        void push_released(handle_t handle, detail::graph_state const* state) noexcept;
+
+    public:
+        explicit executor(executor_options options = {});
+
+        executor(executor const&) = delete;
+        executor(executor&&) = delete;
+
+        /// <summary>
+        /// Waits for every submitted node to be executed, then joins the workers.
+        /// </summary>
+        ~executor();
+
+        /// <summary>
+        /// Constructs a node inside the executor's node pool, that doesn't belong to any graph.
+        /// </summary>
+        /// <param name="wait_no">How many nodes have to complete before this one can run.</param>
+        /// <param name="successors">Nodes that wait for this one, can be nullptr if sz is 0.</param>
+        /// <param name="sz">How many successors.</param>
+        /// <param name="c">Callable to execute.</param>
+        /// <param name="...args">Callable's arguments.</param>
+        /// <returns>The node's handle.</returns>
+        template<typename Callable, typename... Args>
+        handle_t make_node(std::int32_t wait_no, handle_t* successors, std::uint32_t sz, Callable&& c, Args&&... args);
+
+        /// <summary>
+        /// Destroys a node that is not going to be executed anymore.
+        /// </summary>
+        void destroy_node(handle_t handle) noexcept;
+
+        /// <summary>
+        /// Accesses a node through its handle.
+        /// </summary>
+        detail::node& get_node(handle_t handle) noexcept;
+
+        /// <summary>
+        /// Enqueues a ready node, that is a node whose wait_counter is 0.
+        /// From a worker it goes to the worker's own queue, otherwise to one of the workers' inbox.
+        /// </summary>
+        void submit(handle_t handle) noexcept;
+
+        /// <summary>
+        /// Materializes the graph's nodes and enqueues the ones without predecessors, all at once.
+        /// With scheduling_mode::critical_path, each node's priority is the heaviest path from it to the end of the graph.
+        /// With a worker cap or executor_options::fair_share, the nodes over the graph's limit wait for one of its nodes to complete.
+        /// With a deadline, the nodes are dispatched before the ones of graphs with a later deadline, or none.
+        /// With I/O nodes, the first submission creates the executor's io_uring instance.
+        ///
+        /// A graph that completed can be submitted again: its nodes are reused, only their counters are reset,
+        /// and its current deadline, worker cap and share apply to the new run.
+        ///
+        /// Throws: logic_error
+        ///         when the graph contains a cycle, or its previous submission didn't complete yet
+        /// </summary>
+        void submit(graph& g);
+
+        /// <summary>
+        /// Blocks until every node of a submitted graph has been executed.
+        /// Meanwhile the calling thread executes ready nodes, so a node can wait for a nested graph without taking a worker away from the pool.
+        /// The graph can be destroyed as soon as this returns.
+        /// </summary>
+        void wait(graph& g) noexcept;
+
+        /// <summary>
+        /// Executes a callable on a worker every period, starting one period from now.
+        /// A run is skipped when the previous one is still going, i.e. until the callable returned:
+        /// to submit a graph periodically, use the overload that takes the graph.
+        /// The period is rounded up to executor_options::timer_resolution.
+        /// </summary>
+        /// <returns>The id to pass to cancel_every().</returns>
+        template<typename Callable, typename... Args>
+        handle_t submit_every(std::chrono::steady_clock::duration period, Callable&& c, Args&&... args);
+
+        /// <summary>
+        /// Submits a graph every period, starting one period from now.
+        /// A run is skipped while the graph's previous run didn't complete, or when the graph can't be submitted.
+        /// The graph must outlive the periodic submission, see cancel_every().
+        /// </summary>
+        /// <returns>The id to pass to cancel_every().</returns>
+        handle_t submit_every(std::chrono::steady_clock::duration period, graph& g);
+
+        /// <summary>
+        /// Stops a periodic submission, a run that already started isn't interrupted.
+        /// Its resources are released at what would have been its next run, so it can be called only once.
+        /// </summary>
+        void cancel_every(handle_t periodic) noexcept;
+
+        /// <summary>
+        /// Spawns a child of the node running on the calling thread, e.g. to split its work recursively.
+        /// The node's successors are released only once every child completed, with the children's own children,
+        /// but the worker doesn't wait for them: it moves on as soon as the node's callable returns.
+        /// The children belong to the node's graph. With executor_options::fuse_chains, a fused chain stops after a node
+        /// that spawned, and the next node of the chain runs once the children completed, like it would without fusion.
+        ///
+        /// Throws: logic_error
+        ///         when the calling thread isn't running one of this executor's nodes
+        /// </summary>
+        template<typename Callable, typename... Args>
+        void spawn(Callable&& c, Args&&... args);
+
+        /// <summary>
+        /// Whether a running node should hand part of its remaining work over to spawn(), for lazy splitting:
+        /// true when some worker is parked, or when the calling worker's queue is empty,
+        /// since the thieves took whatever it pushed before.
+        /// </summary>
+        bool should_split() const noexcept;
+
+        /// <summary>
+        /// Blocks until every submitted node has been executed.
+        /// </summary>
+        void wait_idle() noexcept;
+
+        /// <summary>
+        /// How many workers are running, it changes over time with executor_options::elastic.
+        /// </summary>
+        std::uint32_t worker_count() const noexcept;
+    };
+
+    template<typename Callable, typename ...Args>
+    inline handle_t executor::make_node(std::int32_t wait_no, handle_t* successors, std::uint32_t sz, Callable&& c, Args && ...args)
+    {
+        auto* res = options.node_pool.resource;
+        auto* payload = detail::make_payload(res, std::forward<Callable>(c), std::forward<Args>(args)...);
+
+        return node_pool.construct(res, detail::no_graph, wait_no, payload, successors, sz);
+    }
+
+    template<typename Callable, typename ...Args>
+    inline handle_t executor::submit_every(std::chrono::steady_clock::duration period, Callable&& c, Args && ...args)
+    {
+        auto* payload = detail::make_payload(options.node_pool.resource, std::forward<Callable>(c), std::forward<Args>(args)...);
+
+        return start_every(period, payload);
+    }
+
+    template<typename Callable, typename ...Args>
+    inline void executor::spawn(Callable&& c, Args && ...args)
+    {
+        auto* payload = detail::make_payload(options.node_pool.resource, std::forward<Callable>(c), std::forward<Args>(args)...);
+
+        spawn_child(payload);
+    }
+}
@@ -0,0 +1,373 @@
+#include "graph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // Targets whose reachability is computed in one pass, one bit each
+    constexpr std::size_t block_size = 64;
+    // Graphs with fewer nodes are reduced by the submitting thread alone
+    constexpr std::size_t parallel_reduction_threshold = 4096;
+}
+
+taskete::graph::graph(executor& exec)
+    : owner(exec)
+    , infos(exec.options.node_pool.resource)
+    , handles(exec.options.node_pool.resource)
+    , roots(exec.options.node_pool.resource)
+    , branch_tables(exec.options.node_pool.resource)
+    , dependencies(exec.options.node_pool.resource)
+{}
+
+taskete::graph::~graph()
+{
+    if (submitted())
+    {
+        // The nodes own the payloads now
+        for (auto h : handles)
+            owner.destroy_node(h);
+        owner.graph_pool.destroy(state);
+        return;
+    }
+
+    for (auto& info : infos)
+    {
+        if (!info.payload)
+            continue;
+
+        auto payload_size = info.payload->size_of();
+        info.payload->~execution_payload();
+        resource()->deallocate(info.payload, payload_size);
+    }
+}
+
+taskete::graph::node_id taskete::graph::emplace_io(io_request& request)
+{
+    check_editable();
+
+    return add(nullptr, &request);
+}
+
+taskete::graph::node_id taskete::graph::add(detail::execution_payload* payload, io_request* io)
+{
+    infos.push_back({ payload, std::pmr::vector<node_id>(resource()), 0, 1, detail::no_worker, detail::no_predecessor, io, 0,
+        nullptr, std::pmr::vector<branch>(resource()), false, false, handle_t{} });
+
+    return node_id(infos.size() - 1);
+}
+
+void taskete::graph::check_editable() const
+{
+    if (submitted())
+        throw std::logic_error{ "taskete::graph can't change its nodes once it was submitted" };
+}
+
+taskete::graph& taskete::graph::precede(node_id before, node_id after)
+{
+    check_editable();
+
+    infos[before].successors.push_back(after);
+    ++infos[after].predecessors;
+
+    if (infos[before].condition)
+        infos[before].branches.push_back({ after, false });
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::loop_back(node_id condition, node_id target)
+{
+    check_editable();
+
+    infos[condition].branches.push_back({ target, true });
+    infos[target].loop_target = true;
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::start_after(graph& other)
+{
+    dependencies.push_back({ &other, detail::whole_graph });
+    return *this;
+}
+
+taskete::graph& taskete::graph::start_after(graph& other, node_id node)
+{
+    // Once materialized, its nodes can't start watching
+    if (!other.submitted())
+        other.infos[node].watched = true;
+
+    dependencies.push_back({ &other, std::int64_t(node) });
+    return *this;
+}
+
+taskete::graph& taskete::graph::weight(node_id node, std::uint32_t w)
+{
+    check_editable();
+
+    infos[node].weight = w;
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::prefer_worker(node_id node, std::uint32_t worker)
+{
+    check_editable();
+
+    infos[node].preferred_worker = std::int32_t(worker);
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::follow(node_id node, node_id predecessor)
+{
+    check_editable();
+
+    infos[node].follows = std::int64_t(predecessor);
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::delay(node_id node, std::chrono::steady_clock::duration d)
+{
+    check_editable();
+
+    infos[node].delay = std::max<std::int64_t>(d.count(), 0);
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::max_workers(std::uint32_t count) noexcept
+{
+    worker_cap = count;
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::share(std::uint32_t weight) noexcept
+{
+    worker_share = weight ? weight : 1;
+
+    return *this;
+}
+
+taskete::graph& taskete::graph::deadline(std::chrono::steady_clock::time_point when) noexcept
+{
+    // Nothing can be later than no deadline at all
+    due = std::min<std::int64_t>(when.time_since_epoch().count(), detail::no_deadline - 1);
+
+    return *this;
+}
+
+void taskete::graph::cancel() noexcept
+{
+    if (submitted())
+        owner.cancel_graph(state);
+    else
+        cancel_requested = true;
+}
+
+bool taskete::graph::cancelled() const noexcept
+{
+    return submitted() ? owner.graph_pool.get(state).cancelled.load(std::memory_order_relaxed) : cancel_requested;
+}
+
+std::uint32_t taskete::graph::size() const noexcept
+{
+    return std::uint32_t(infos.size());
+}
+
+bool taskete::graph::submitted() const noexcept
+{
+    return !handles.empty();
+}
+
+std::pmr::memory_resource* taskete::graph::resource() const noexcept
+{
+    return infos.get_allocator().resource();
+}
+
+/*
+ * Kahn's algorithm, the order is also used to materialize the nodes backwards,
+ * as a node needs the handles of its successors to be constructed.
+ */
+std::pmr::vector<taskete::graph::node_id> taskete::graph::topological_order() const
+{
+    std::pmr::vector<std::int32_t> missing(resource());
+    missing.reserve(infos.size());
+    for (auto& info : infos)
+        missing.push_back(info.predecessors);
+
+    std::pmr::vector<node_id> order(resource());
+    order.reserve(infos.size());
+    for (node_id id = 0; id < size(); ++id)
+        if (!missing[id])
+            order.push_back(id);
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+        for (auto successor : infos[order[i]].successors)
+            if (!--missing[successor])
+                order.push_back(successor);
+
+    if (order.size() != infos.size())
+        throw std::logic_error{ "taskete::graph contains a cycle" };
+
+    return order;
+}
+
+/*
+ * A bitset of reachable nodes for each node would take quadratic memory, so the targets are split in blocks:
+ * going backwards, a word per node tells which targets of the block it reaches.
+ * An edge is redundant when its target is reached through the other successors, or was already declared.
+ * Paths through a condition node don't count, it might take another branch.
+ * The blocks are independent, the ones of large graphs are spread over lanes that run as nodes of the executor,
+ * while the submitting thread waits for them like for any graph.
+ */
+void taskete::graph::reduce_edges(std::pmr::vector<node_id> const& order)
+{
+    std::pmr::vector<std::size_t> first_edge(infos.size() + 1, 0, resource());
+    for (node_id id = 0; id < size(); ++id)
+        first_edge[id + 1] = first_edge[id] + infos[id].successors.size();
+
+    auto blocks = (infos.size() + block_size - 1) / block_size;
+    std::size_t lanes = 1;
+    if (infos.size() >= parallel_reduction_threshold)
+        lanes = std::min<std::size_t>(std::max(1u, owner.worker_count()), blocks);
+
+    // Allocated here, the resource might not be thread-safe
+    std::pmr::vector<char> redundant(first_edge.back(), false, resource());
+    std::pmr::vector<std::uint64_t> reach(lanes * infos.size(), 0, resource());
+
+    // Each lane has its own words, and the edges of a block are only marked by the lane that owns it
+    auto reduce_blocks = [this, &order, &first_edge, &redundant, &reach, blocks, lanes](std::size_t first_block)
+    {
+        auto* reaches = reach.data() + first_block * infos.size();
+
+        for (auto block = first_block; block < blocks; block += lanes)
+        {
+            auto base = block * block_size;
+
+            for (auto it = order.rbegin(); it != order.rend(); ++it)
+            {
+                auto& successors = infos[*it].successors;
+
+                // A condition's edges are branches, none of them is implied, and the paths through it might not be taken
+                if (infos[*it].condition)
+                {
+                    reaches[*it] = 0;
+                    continue;
+                }
+
+                std::uint64_t through = 0;
+                for (auto successor : successors)
+                    through |= reaches[successor];
+
+                std::uint64_t direct = 0;
+                for (std::size_t i = 0; i < successors.size(); ++i)
+                {
+                    if (successors[i] < base || successors[i] >= base + block_size)
+                        continue;
+
+                    auto bit = std::uint64_t(1) << (successors[i] - base);
+                    if ((through | direct) & bit)
+                        redundant[first_edge[*it] + i] = true;
+                    direct |= bit;
+                }
+
+                reaches[*it] = through | direct;
+            }
+        }
+    };
+
+    if (lanes == 1)
+        reduce_blocks(0);
+    else
+    {
+        graph reduction{ owner };
+        for (std::size_t lane = 0; lane < lanes; ++lane)
+            reduction.emplace([&reduce_blocks, lane] { reduce_blocks(lane); });
+
+        owner.submit(reduction);
+        owner.wait(reduction);
+    }
+
+    for (node_id id = 0; id < size(); ++id)
+    {
+        auto& successors = infos[id].successors;
+
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < successors.size(); ++i)
+        {
+            if (redundant[first_edge[id] + i])
+                --infos[successors[i]].predecessors;
+            else
+                successors[kept++] = successors[i];
+        }
+
+        successors.resize(kept);
+    }
+}
+
+std::pmr::vector<std::int64_t> taskete::graph::chain_links() const
+{
+    std::pmr::vector<std::int64_t> next(infos.size(), detail::no_predecessor, resource());
+
+    for (node_id id = 0; id < size(); ++id)
+    {
+        auto& info = infos[id];
+        if (info.successors.size() != 1 || info.io)
+            continue;
+
+        auto successor = info.successors.front();
+        auto& link = infos[successor];
+        bool pinned = link.preferred_worker != detail::no_worker || (link.follows != detail::no_predecessor && link.follows != std::int64_t(id));
+        bool branching = info.condition || link.condition || link.loop_target;
+        if (link.predecessors != 1 || link.io || link.delay || pinned || branching)
+            continue;
+
+        next[id] = std::int64_t(successor);
+    }
+
+    return next;
+}
+
+/*
+ * The body is what the target reaches, intersected with what reaches the condition.
+ */
+std::pmr::vector<bool> taskete::graph::loop_body(node_id target, node_id condition, std::pmr::vector<node_id> const& order) const
+{
+    std::pmr::vector<bool> reached(infos.size(), false, resource());
+    std::pmr::vector<bool> reaching(infos.size(), false, resource());
+
+    reached[target] = true;
+    for (auto id : order)
+        if (reached[id])
+            for (auto successor : infos[id].successors)
+                reached[successor] = true;
+
+    reaching[condition] = true;
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+        for (auto successor : infos[*it].successors)
+            if (reaching[successor])
+                reaching[*it] = true;
+
+    if (!reaching[target])
+        throw std::logic_error{ "taskete::graph loop starts at a node that doesn't precede its condition" };
+
+    std::pmr::vector<bool> body(infos.size(), false, resource());
+    for (node_id id = 0; id < size(); ++id)
+        body[id] = reached[id] && reaching[id];
+
+    for (node_id id = 0; id < size(); ++id)
+    {
+        if (!body[id] || id == condition)
+            continue;
+
+        for (auto successor : infos[id].successors)
+            if (!body[successor])
+                throw std::logic_error{ "taskete::graph loop can be left only through its condition" };
+    }
+
+    return body;
+}
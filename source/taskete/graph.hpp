@@ -0,0 +1,281 @@
+#pragma once
+
+#include <taskete/handle.hpp>
+
+#include "macro_utils.hpp"
+#include "execution_payload.hpp"
+#include "executor.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace taskete
+{
+    /// <summary>
+    /// Static DAG of nodes, executed by the executor it was created with.
+    ///
+    /// Nodes are materialized inside the executor only when the graph is submitted the first time,
+    /// and destroyed with the graph, so the graph must outlive its execution.
+    /// Once it completed, the graph can be submitted again and its nodes are reused.
+    ///
+    /// Throws: logic_error
+    ///         when a node or an edge is added, or a node's settings are changed, once the graph was submitted:
+    ///         its nodes are materialized already and wouldn't see it
+    /// </summary>
+    class TASKETE_LIB_SYMBOLS graph
+    {
+        friend class executor;
+
+    public:
+        using node_id = std::uint32_t;
+
+    private:
+        // Edge of a condition node, in the order they were declared
+        struct branch
+        {
+            node_id target;
+            bool loop;
+        };
+
+        struct node_info
+        {
+            detail::execution_payload* payload; // nullptr for I/O nodes
+            std::pmr::vector<node_id> successors;
+            std::int32_t predecessors;
+            std::uint32_t weight;
+            std::int32_t preferred_worker;
+            std::int64_t follows; // node_id
+            io_request* io;
+            std::int64_t delay; // steady_clock ticks
+
+            detail::condition_payload* condition; // same object as payload, for condition nodes
+            std::pmr::vector<branch> branches;     // condition nodes only
+            bool loop_target;                      // some loop starts here
+            bool watched;                          // another graph starts after this node
+            handle_t handle;                       // filled once submitted, of the node materialized for our chain
+        };
+
+        // Another graph this one starts after, or after one of its nodes
+        struct dependency
+        {
+            graph* other;
+            std::int64_t node; // node_id, or whole_graph
+        };
+
+        executor& owner;
+        std::pmr::vector<node_info> infos;
+        std::pmr::vector<handle_t> handles; // filled once submitted, the materialized nodes
+        std::pmr::vector<handle_t> roots;   // filled once submitted, the nodes without predecessors
+        std::pmr::deque<detail::branch_table> branch_tables; // filled once submitted, one per condition node
+        std::pmr::vector<dependency> dependencies;
+        handle_t state{};                   // valid once submitted
+
+        std::uint32_t worker_cap = 0;
+        std::uint32_t worker_share = 1;
+        std::int64_t due = detail::no_deadline; // steady_clock ticks
+        bool cancel_requested = false;          // until it's submitted, then it's in the state
+
+        std::pmr::memory_resource* resource() const noexcept;
+
+        node_id add(detail::execution_payload* payload, io_request* io);
+
+        /*
+         * Throws: logic_error
+         *         once the graph was submitted
+         */
+        void check_editable() const;
+
+        /*
+         * Every node comes after its predecessors.
+         *
+         * Throws: logic_error
+         *         when the graph contains a cycle
+         */
+        std::pmr::vector<node_id> topological_order() const;
+
+        /*
+         * Transitive reduction: drops the edges whose target is reachable through another successor, and the duplicated ones.
+         * The predecessors are updated to match, the order stays valid.
+         */
+        void reduce_edges(std::pmr::vector<node_id> const& order);
+
+        /*
+         * For each node, the next one in its chain, or no_predecessor.
+         * A chain goes on from a node with a single successor to that successor when it has no other predecessor,
+         * unless one of them does I/O or is a condition, or the successor has to wait, to run on a specific worker, or starts a loop.
+         */
+        std::pmr::vector<std::int64_t> chain_links() const;
+
+        /*
+         * The nodes on the paths from 'target' to 'condition', a loop's body.
+         *
+         * Throws: logic_error
+         *         when 'target' doesn't precede 'condition',
+         *         or a node of the body has a successor outside of it, other than through the condition
+         */
+        std::pmr::vector<bool> loop_body(node_id target, node_id condition, std::pmr::vector<node_id> const& order) const;
+
+    public:
+        explicit graph(executor& exec);
+
+        graph(graph const&) = delete;
+        graph(graph&&) = delete;
+
+        ~graph();
+
+        /// <summary>
+        /// Adds a node that executes the given callable.
+        /// </summary>
+        /// <param name="c">Callable to execute.</param>
+        /// <param name="...args">Callable's arguments.</param>
+        /// <returns>The node's id inside this graph.</returns>
+        template<typename Callable, typename... Args>
+        node_id emplace(Callable&& c, Args&&... args);
+
+        /// <summary>
+        /// Adds a condition node: its callable returns the index of the branch to take,
+        /// among the node's successors and loops, in the order they were declared.
+        ///
+        /// The successor of the branch taken is released like usual, the others are released without running:
+        /// a node runs only if at least one of its predecessors ran, otherwise it's skipped and so are its successors.
+        /// An index past the last branch takes none of them.
+        /// </summary>
+        /// <param name="c">Callable to execute, it returns an integer.</param>
+        /// <param name="...args">Callable's arguments.</param>
+        /// <returns>The node's id inside this graph.</returns>
+        template<typename Callable, typename... Args>
+        node_id emplace_condition(Callable&& c, Args&&... args);
+
+        /// <summary>
+        /// Adds a node that executes an I/O request through the executor's io_uring instance.
+        /// The node doesn't occupy a worker while the kernel works, its successors are released once the request completes,
+        /// and they can read its result from the request.
+        /// Where io_uring isn't available, the request is executed synchronously by a worker.
+        /// </summary>
+        /// <param name="request">The request to execute, it must outlive the graph's execution.</param>
+        /// <returns>The node's id inside this graph.</returns>
+        node_id emplace_io(io_request& request);
+
+        /// <summary>
+        /// Orders the execution of 2 nodes: 'after' runs only once 'before' completed.
+        /// </summary>
+        graph& precede(node_id before, node_id after);
+
+        /// <summary>
+        /// Adds a branch to a condition node that runs the nodes from 'target' to the condition again:
+        /// the body of the loop is made of the nodes on the paths between them, the condition's successors wait for it to exit.
+        /// The body can't be left other than through the condition.
+        ///
+        /// Throws (on submission): logic_error
+        ///         when 'target' doesn't precede 'condition', or the body has other exits
+        /// </summary>
+        graph& loop_back(node_id condition, node_id target);
+
+        /// <summary>
+        /// Makes this graph start only once 'other' completed, without blocking the thread that submits it:
+        /// the executor dispatches this graph's roots itself. This graph waits for the run of 'other' in progress when it's submitted,
+        /// if 'other' completed already it starts right away. A cancelled graph completes too.
+        /// Graphs can't wait for each other in a cycle.
+        ///
+        /// Throws (on submission): logic_error
+        ///         when 'other' belongs to another executor, is this graph, or was never submitted
+        /// </summary>
+        graph& start_after(graph& other);
+
+        /// <summary>
+        /// Like start_after(other), but this graph starts once the given node of 'other' completed.
+        /// The node is watched only if this is called before 'other' is submitted the first time,
+        /// otherwise this graph waits for the whole of 'other'. With executor_options::fuse_chains, it waits for the node's chain.
+        /// </summary>
+        graph& start_after(graph& other, node_id node);
+
+        /// <summary>
+        /// Hints how expensive a node is compared to the others, defaults to 1.
+        /// Used by scheduling_mode::critical_path.
+        /// </summary>
+        graph& weight(node_id node, std::uint32_t w);
+
+        /// <summary>
+        /// Hints that a node should run on the given worker, e.g. the one whose cache holds its inputs.
+        /// Only that worker can run it, until executor_options::affinity_grace expires.
+        /// </summary>
+        graph& prefer_worker(node_id node, std::uint32_t worker);
+
+        /// <summary>
+        /// Hints that a node should run on the same worker as one of its predecessors, that produced its inputs.
+        /// Only that worker can run it, until executor_options::affinity_grace expires.
+        ///
+        /// Throws (on submission): logic_error
+        ///         when 'predecessor' doesn't precede 'node'
+        /// </summary>
+        graph& follow(node_id node, node_id predecessor);
+
+        /// <summary>
+        /// Makes a node wait the given time once its predecessors completed (or once the graph is submitted, for a root),
+        /// before it's dispatched. The node doesn't occupy a worker meanwhile.
+        /// The delay is rounded up to executor_options::timer_resolution.
+        /// </summary>
+        graph& delay(node_id node, std::chrono::steady_clock::duration d);
+
+        /// <summary>
+        /// Limits how many workers can execute this graph's nodes at the same time, 0 means no limit.
+        /// </summary>
+        graph& max_workers(std::uint32_t count) noexcept;
+
+        /// <summary>
+        /// Weight of this graph among the active ones, defaults to 1.
+        /// Used when executor_options::fair_share is enabled.
+        /// </summary>
+        graph& share(std::uint32_t weight) noexcept;
+
+        /// <summary>
+        /// Asks to complete the graph before the given time.
+        /// Workers prefer the ready nodes of the graph with the earliest deadline,
+        /// but every executor_options::deadline_burst nodes they give a chance to the graphs without one.
+        /// </summary>
+        graph& deadline(std::chrono::steady_clock::time_point when) noexcept;
+
+        /// <summary>
+        /// Asks to stop the graph: the nodes that didn't start yet are skipped, but they still release their successors,
+        /// so the graph completes as soon as the running ones end. An I/O node that is skipped gets -ECANCELED as result.
+        /// It can be called from any thread, even from the graph's own nodes, but not while the graph is being submitted.
+        /// </summary>
+        void cancel() noexcept;
+
+        /// <summary>
+        /// Whether cancel() was called, a long node can check it to stop early.
+        /// </summary>
+        bool cancelled() const noexcept;
+
+        std::uint32_t size() const noexcept;
+
+        bool submitted() const noexcept;
+    };
+
+    template<typename Callable, typename ...Args>
+    inline graph::node_id graph::emplace(Callable&& c, Args && ...args)
+    {
+        check_editable();
+
+        auto* payload = detail::make_payload(resource(), std::forward<Callable>(c), std::forward<Args>(args)...);
+
+        return add(payload, nullptr);
+    }
+
+    template<typename Callable, typename ...Args>
+    inline graph::node_id graph::emplace_condition(Callable&& c, Args && ...args)
+    {
+        check_editable();
+
+        auto* payload = detail::make_condition(resource(), std::forward<Callable>(c), std::forward<Args>(args)...);
+
+        auto id = add(payload, nullptr);
+        infos[id].condition = payload;
+
+        return id;
+    }
+}
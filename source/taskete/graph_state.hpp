@@ -0,0 +1,71 @@
+#pragma once
+
+#include <taskete/handle.hpp>
+
+#include "lock_helpers.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+namespace taskete
+{
+    class graph;
+}
+
+namespace taskete::detail
+{
+    // steady_clock ticks of a graph without a deadline, it sorts after every real one
+    constexpr std::int64_t no_deadline = std::numeric_limits<std::int64_t>::max();
+
+    // What a graph waits for when it starts after a whole graph
+    constexpr std::int64_t whole_graph = -1;
+
+    // A graph that starts after another one completes, or after one of its nodes does
+    struct graph_dependent
+    {
+        std::int64_t node; // handle, or whole_graph
+        handle_t state;    // of the dependent graph
+    };
+
+    /*
+     * Runtime data of a submitted graph, shared by all its nodes.
+     * Each node refers to it through its graph_id, that is the handle of the state.
+     */
+    struct graph_state
+    {
+        std::atomic<std::int64_t> pending{ 0 };  // ready or running nodes, 0 means the graph completed
+        std::atomic<bool> done{ false };         // set once the graph completed, it's the last time the executor touches us
+        std::int64_t deadline = no_deadline;     // steady_clock ticks
+        std::atomic<bool> cancelled{ false };    // the nodes that didn't start yet are skipped
+
+        // Concurrency cap
+        bool limited;                            // false when there's no cap to enforce
+        std::uint32_t max_workers;               // 0 means no hard cap
+        std::uint32_t share;                     // weight among the active graphs
+        std::atomic<std::uint32_t> running{ 0 }; // slots taken by workers executing our nodes
+
+        // Ready nodes that couldn't run because we were already at the cap
+        spinlock deferred_lock;
+        std::atomic<std::uint32_t> deferred_count{ 0 };
+        std::pmr::deque<handle_t> deferred;
+
+        // Graphs that start after this one, or after one of its nodes
+        spinlock dependents_lock;
+        std::uint32_t run = 0;                        // counts the submissions, under dependents_lock
+        bool finished = false;                        // the current run completed, under dependents_lock
+        std::pmr::vector<graph_dependent> dependents; // under dependents_lock
+
+        // Graphs this one starts after
+        std::atomic<std::int32_t> gates{ 0 }; // dependencies not resolved yet, plus 1 while they're being registered
+        graph* held = nullptr;                // launched once gates drops to 0
+        graph_state* next_held = nullptr;     // the next graph to launch, once the lock that resolved us is released
+
+        graph_state(std::pmr::memory_resource* res, bool limited, std::uint32_t max_workers, std::uint32_t share)
+            : limited(limited), max_workers(max_workers), share(share), deferred(res), dependents(res)
+        {}
+    };
+}
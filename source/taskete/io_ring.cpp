@@ -0,0 +1,338 @@
+#include "io_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(__linux__)
+    // The rings' cursors are written by the kernel, so they are accessed through the atomic builtins
+    std::uint32_t load_acquire(void const* ring, std::uint32_t offset) noexcept
+    {
+        return __atomic_load_n(reinterpret_cast<std::uint32_t const*>(static_cast<char const*>(ring) + offset), __ATOMIC_ACQUIRE);
+    }
+
+    void store_release(void* ring, std::uint32_t offset, std::uint32_t value) noexcept
+    {
+        __atomic_store_n(reinterpret_cast<std::uint32_t*>(static_cast<char*>(ring) + offset), value, __ATOMIC_RELEASE);
+    }
+
+    template<typename T>
+    T* at(void* ring, std::uint32_t offset) noexcept
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+
+    int enter(int fd, std::uint32_t to_submit, std::uint32_t min_complete, std::uint32_t flags) noexcept
+    {
+        return int(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+#if defined(IORING_FEAT_EXT_ARG)
+    // How long the waiter blocks before it looks for a stop() whose completion didn't come
+    constexpr long long wait_timeout_ns = 50'000'000;
+
+    // Fails with ETIME once the timeout expired
+    int wait_events(int fd) noexcept
+    {
+        __kernel_timespec timeout{ 0, wait_timeout_ns };
+        io_uring_getevents_arg arg{};
+        arg.ts = std::uint64_t(reinterpret_cast<std::uintptr_t>(&timeout));
+
+        return int(syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)));
+    }
+#endif
+
+    std::uint8_t opcode_of(taskete::io_op op) noexcept
+    {
+        switch (op)
+        {
+        case taskete::io_op::read: return IORING_OP_READ;
+        case taskete::io_op::write: return IORING_OP_WRITE;
+        default: return IORING_OP_FSYNC;
+        }
+    }
+
+    /*
+     * IORING_OP_READ and IORING_OP_WRITE came with 5.6, like the probe itself:
+     * on older kernels the ring can be created, but every read or write would fail with -EINVAL.
+     */
+    bool supports_opcodes(int fd) noexcept
+    {
+        constexpr std::uint8_t needed[] = { IORING_OP_NOP, IORING_OP_FSYNC, IORING_OP_READ, IORING_OP_WRITE };
+        constexpr std::uint32_t probed = 256;
+
+        alignas(io_uring_probe) unsigned char buffer[sizeof(io_uring_probe) + probed * sizeof(io_uring_probe_op)]{};
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer);
+
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, probed) < 0)
+            return false;
+
+        for (auto opcode : needed)
+            if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED))
+                return false;
+
+        return true;
+    }
+#endif
+}
+
+taskete::detail::io_ring::~io_ring()
+{
+    close();
+}
+
+/*
+ * The waiter must be able to time out, a stop() the ring refused would keep it blocked forever otherwise:
+ * that needs IORING_FEAT_EXT_ARG, from 5.11.
+ */
+bool taskete::detail::io_ring::open(std::uint32_t entries) noexcept
+{
+#if defined(__linux__) && defined(IORING_FEAT_EXT_ARG)
+    io_uring_params params{};
+    auto fd = int(syscall(__NR_io_uring_setup, std::max(entries, 1u), &params));
+    if (fd < 0)
+        return false;
+
+    ring_fd = fd;
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !supports_opcodes(fd))
+    {
+        close();
+        return false;
+    }
+
+    sq_entries = params.sq_entries;
+    cq_entries = params.cq_entries;
+    sq_offsets = { params.sq_off.head, params.sq_off.tail, params.sq_off.ring_mask, params.sq_off.array };
+    cq_offsets = { params.cq_off.head, params.cq_off.tail, params.cq_off.ring_mask, params.cq_off.cqes };
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqe_array_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    // Since 5.4 both rings live in the same mapping
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+    auto map = [fd](std::size_t size, off_t offset)
+    {
+        auto* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    };
+
+    sq_ring = map(sq_ring_size, off_t(IORING_OFF_SQ_RING));
+    cq_ring = single_mmap ? sq_ring : map(cq_ring_size, off_t(IORING_OFF_CQ_RING));
+    sqe_array = map(sqe_array_size, off_t(IORING_OFF_SQES));
+
+    if (!sq_ring || !cq_ring || !sqe_array)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+#else
+    (void)entries;
+    return false;
+#endif
+}
+
+bool taskete::detail::io_ring::available() const noexcept
+{
+    return ring_fd >= 0;
+}
+
+void taskete::detail::io_ring::close() noexcept
+{
+#if defined(__linux__)
+    if (sqe_array)
+        munmap(sqe_array, sqe_array_size);
+    if (cq_ring && cq_ring != sq_ring)
+        munmap(cq_ring, cq_ring_size);
+    if (sq_ring)
+        munmap(sq_ring, sq_ring_size);
+    if (ring_fd >= 0)
+        ::close(ring_fd);
+#endif
+
+    sq_ring = cq_ring = sqe_array = nullptr;
+    ring_fd = -1;
+}
+
+bool taskete::detail::io_ring::submit(io_request const& request, std::uint64_t user_data) noexcept
+{
+#if defined(__linux__)
+    return enqueue(opcode_of(request.op), &request, user_data);
+#else
+    (void)request;
+    (void)user_data;
+    return false;
+#endif
+}
+
+bool taskete::detail::io_ring::stop() noexcept
+{
+#if defined(__linux__)
+    stopping.store(true, std::memory_order_release);
+    return enqueue(IORING_OP_NOP, nullptr, stop_marker);
+#else
+    return false;
+#endif
+}
+
+/*
+ * Without SQPOLL the kernel reads the submission queue only inside io_uring_enter(),
+ * so once it refused our entry we can take it back: the queue is always empty between 2 submissions.
+ */
+bool taskete::detail::io_ring::enqueue(std::uint8_t opcode, io_request const* request, std::uint64_t user_data) noexcept
+{
+#if defined(__linux__)
+    if (!available())
+        return false;
+
+    std::unique_lock lock{ submit_lock };
+
+    // Without IORING_FEAT_NODROP an overflowing completion is lost, and its node would never complete
+    if (in_flight >= cq_entries)
+        return false;
+
+    auto tail = *at<std::uint32_t>(sq_ring, sq_offsets.tail);
+    if (tail - load_acquire(sq_ring, sq_offsets.head) >= sq_entries)
+        return false;
+
+    auto index = tail & *at<std::uint32_t>(sq_ring, sq_offsets.mask);
+    auto& sqe = static_cast<io_uring_sqe*>(sqe_array)[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+
+    sqe.opcode = opcode;
+    sqe.fd = -1;
+    sqe.user_data = user_data;
+    if (request)
+    {
+        sqe.fd = request->fd;
+        sqe.addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(request->buffer));
+        sqe.len = request->size;
+        sqe.off = request->offset;
+        if (request->op == io_op::fdatasync)
+            sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+    }
+
+    at<std::uint32_t>(sq_ring, sq_offsets.entries)[index] = index;
+    store_release(sq_ring, sq_offsets.tail, tail + 1);
+
+    int submitted = 0;
+    do
+        submitted = enter(ring_fd, 1, 0, 0);
+    while (submitted < 0 && errno == EINTR);
+
+    if (submitted != 1)
+    {
+        store_release(sq_ring, sq_offsets.tail, tail);
+        return false;
+    }
+
+    ++in_flight;
+    return true;
+#else
+    (void)opcode;
+    (void)request;
+    (void)user_data;
+    return false;
+#endif
+}
+
+std::uint32_t taskete::detail::io_ring::wait(io_completion* completions, std::uint32_t capacity) noexcept
+{
+#if defined(__linux__) && defined(IORING_FEAT_EXT_ARG)
+    if (!available())
+        return 0;
+
+    bool timed_out = false;
+    while (true)
+    {
+        auto head = *at<std::uint32_t>(cq_ring, cq_offsets.head);
+        auto tail = load_acquire(cq_ring, cq_offsets.tail);
+
+        if (head != tail)
+        {
+            auto mask = *at<std::uint32_t>(cq_ring, cq_offsets.mask);
+            auto* cqes = at<io_uring_cqe>(cq_ring, cq_offsets.entries);
+
+            std::uint32_t count = 0;
+            for (; head != tail && count < capacity; ++head, ++count)
+            {
+                auto& cqe = cqes[head & mask];
+                completions[count] = { cqe.user_data, cqe.res };
+            }
+
+            // The kernel can reuse the entries only now
+            store_release(cq_ring, cq_offsets.head, head);
+
+            // The submitters completed io_uring_enter() under the lock, taking it orders
+            // whatever they wrote before submitting before whatever our caller reads now
+            std::unique_lock lock{ submit_lock };
+            in_flight -= count;
+            return count;
+        }
+
+        // A whole timeout went by since stop(), its completion isn't coming
+        if (timed_out && stopping.load(std::memory_order_acquire))
+            return 0;
+
+        timed_out = false;
+        if (wait_events(ring_fd) < 0)
+        {
+            if (errno == ETIME)
+                timed_out = true;
+            else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                return 0;
+        }
+    }
+#else
+    (void)completions;
+    (void)capacity;
+    return 0;
+#endif
+}
+
+std::int32_t taskete::detail::io_ring::perform(io_request const& request) noexcept
+{
+#if defined(__unix__) || defined(__APPLE__)
+    long result = 0;
+    switch (request.op)
+    {
+    case io_op::read:
+        result = long(pread(request.fd, request.buffer, request.size, off_t(request.offset)));
+        break;
+    case io_op::write:
+        result = long(pwrite(request.fd, request.buffer, request.size, off_t(request.offset)));
+        break;
+    case io_op::fsync:
+        result = fsync(request.fd);
+        break;
+    case io_op::fdatasync:
+#if defined(__APPLE__)
+        result = fsync(request.fd);
+#else
+        result = fdatasync(request.fd);
+#endif
+        break;
+    }
+
+    return result < 0 ? -errno : std::int32_t(result);
+#else
+    (void)request;
+    return -ENOSYS;
+#endif
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <taskete/io_request.hpp>
+
+#include "macro_utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace taskete::detail
+{
+    struct io_completion
+    {
+        std::uint64_t user_data;
+        std::int32_t result; // bytes transferred, or -errno
+    };
+
+    /*
+     * Thin wrapper around an io_uring instance, driven through the raw syscalls.
+     * Any thread can submit, but only one thread at a time can wait for the completions.
+     *
+     * Where io_uring doesn't exist, the kernel refuses to create it or it's too old for our opcodes and timed waits,
+     * the ring is unavailable and every submission fails: the caller has to fall back to perform().
+     */
+    class TASKETE_LIB_SYMBOLS io_ring
+    {
+    private:
+        // Where the cursors and the entries are inside a ring's mapping
+        struct ring_offsets
+        {
+            std::uint32_t head;
+            std::uint32_t tail;
+            std::uint32_t mask;
+            std::uint32_t entries; // the index array for the submission queue, the completions for the other one
+        };
+
+        int ring_fd = -1;
+
+        // Shared with the kernel
+        void* sq_ring = nullptr;
+        void* cq_ring = nullptr;
+        void* sqe_array = nullptr;
+        std::size_t sq_ring_size = 0;
+        std::size_t cq_ring_size = 0;
+        std::size_t sqe_array_size = 0;
+        ring_offsets sq_offsets{};
+        ring_offsets cq_offsets{};
+
+        std::uint32_t sq_entries = 0;
+        std::uint32_t cq_entries = 0;
+        std::uint32_t in_flight = 0; // submitted but not reaped yet, under submit_lock: never more than the completion queue holds
+        std::mutex submit_lock; // the submission queue has a single producer, the waiter takes it to synchronize with them
+        std::atomic<bool> stopping{ false };
+
+        void close() noexcept;
+        bool enqueue(std::uint8_t opcode, io_request const* request, std::uint64_t user_data) noexcept;
+
+    public:
+        // user_data of the completion that wakes up the waiter once stop() is called
+        static constexpr std::uint64_t stop_marker = std::uint64_t(-1);
+
+        io_ring() = default;
+        io_ring(io_ring const&) = delete;
+        io_ring(io_ring&&) = delete;
+        ~io_ring();
+
+        // Creates the ring, returns false when io_uring isn't available
+        bool open(std::uint32_t entries) noexcept;
+        bool available() const noexcept;
+
+        // Hands the request to the kernel, false when either queue is full or the ring is unavailable
+        bool submit(io_request const& request, std::uint64_t user_data) noexcept;
+
+        /*
+         * Blocks until at least one request completes, and copies up to capacity completions.
+         * Returns 0 only if the ring broke down, or once stop() was called but its completion didn't come.
+         */
+        std::uint32_t wait(io_completion* completions, std::uint32_t capacity) noexcept;
+
+        /*
+         * Makes the waiter receive a completion with stop_marker, false when the ring refused it:
+         * the waiter then returns 0 within a timeout instead.
+         */
+        bool stop() noexcept;
+
+        // Executes the request synchronously on the calling thread, returns what the ring would
+        static std::int32_t perform(io_request const& request) noexcept;
+    };
+}
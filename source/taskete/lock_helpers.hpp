@@ -1,16 +1,175 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
 
 namespace taskete::detail
 {
+    /*
+     * Tells the CPU we are busy waiting,
+     * so it can save power and give resources to the sibling hyper-thread.
+     */
+    inline void cpu_relax() noexcept
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
     class spinlock
     {
     public:
-        void lock() noexcept { while(_lock.test_and_set(std::memory_order_acquire)){} }
+        void lock() noexcept { while(_lock.test_and_set(std::memory_order_acquire)){ cpu_relax(); } }
+        bool try_lock() noexcept { return !_lock.test_and_set(std::memory_order_acquire); }
         void unlock() noexcept { _lock.clear(std::memory_order_release); }
 
     private:
         std::atomic_flag _lock = ATOMIC_FLAG_INIT;
     };
-}
\ No newline at end of file
+
+    /*
+     * Exponential backoff for busy waiting:
+     * 1. spins with cpu_relax(), doubling the amount each time
+     * 2. yields the thread
+     * 3. gives up, the caller should block
+     */
+    class backoff
+    {
+    private:
+        static constexpr std::uint32_t spin_limit = 6;   // up to 64 cpu_relax() in a row
+        static constexpr std::uint32_t yield_limit = 10;
+
+        std::uint32_t step = 0;
+
+    public:
+        // Returns false once it's time to block
+        bool spin() noexcept
+        {
+            if (step > yield_limit)
+                return false;
+
+            if (step <= spin_limit)
+            {
+                for (std::uint32_t i = 0; i < (1u << step); ++i)
+                    cpu_relax();
+            }
+            else
+                std::this_thread::yield();
+
+            ++step;
+            return true;
+        }
+
+        void reset() noexcept { step = 0; }
+    };
+
+    /*
+     * Lets threads block until a condition, checked outside of any lock, becomes true.
+     *
+     * Waiter:
+     *     auto key = ec.prepare_wait();
+     *     if (condition) { ec.cancel_wait(); ... }
+     *     else ec.commit_wait(key);
+     *
+     * Notifier:
+     *     make the condition true
+     *     ec.notify_one();
+     *
+     * Notifying is just a load when nobody is waiting.
+     */
+    class eventcount
+    {
+    private:
+        static constexpr std::uint64_t waiter_mask = 0xFFFF'FFFFull;
+        static constexpr std::uint64_t epoch_increment = waiter_mask + 1;
+
+        // Upper 32 bits: epoch, bumped at each notification
+        // Lower 32 bits: how many threads are waiting
+        std::atomic<std::uint64_t> state{ 0 };
+        std::mutex mtx;
+        std::condition_variable cv;
+
+        static std::uint64_t epoch(std::uint64_t s) noexcept { return s & ~waiter_mask; }
+
+        void notify(std::uint64_t count) noexcept
+        {
+            // Pairs with prepare_wait(): either we see the waiter, or it sees the condition
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto waiters = state.load(std::memory_order_relaxed) & waiter_mask;
+            if (!waiters)
+                return;
+
+            {
+                std::unique_lock lock{ mtx };
+                state.fetch_add(epoch_increment, std::memory_order_release);
+            }
+
+            if (count >= waiters)
+                cv.notify_all();
+            else
+                while (count--)
+                    cv.notify_one();
+        }
+
+    public:
+        std::uint64_t prepare_wait() noexcept
+        {
+            auto s = state.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return epoch(s);
+        }
+
+        // Waiters that prepared or committed a wait
+        std::uint32_t waiters() const noexcept
+        {
+            return std::uint32_t(state.load(std::memory_order_relaxed) & waiter_mask);
+        }
+
+        void cancel_wait() noexcept
+        {
+            state.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Blocks until a notification happens after prepare_wait()
+        void commit_wait(std::uint64_t key) noexcept
+        {
+            {
+                std::unique_lock lock{ mtx };
+                cv.wait(lock, [this, key] { return epoch(state.load(std::memory_order_acquire)) != key; });
+            }
+
+            state.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Like commit_wait(), returns false if nobody notified us in time
+        template<typename Rep, typename Period>
+        bool commit_wait_for(std::uint64_t key, std::chrono::duration<Rep, Period> timeout) noexcept
+        {
+            bool notified{};
+            {
+                std::unique_lock lock{ mtx };
+                notified = cv.wait_for(lock, timeout, [this, key] { return epoch(state.load(std::memory_order_acquire)) != key; });
+            }
+
+            state.fetch_sub(1, std::memory_order_relaxed);
+            return notified;
+        }
+
+        void notify_one() noexcept { notify(1); }
+        // Wakes up to 'count' threads with a single epoch bump
+        void notify_many(std::uint32_t count) noexcept { notify(count); }
+        void notify_all() noexcept { notify(waiter_mask); }
+    };
+}
@@ -1,16 +1,11 @@
 #pragma once
 
+#include "macro_utils.hpp"
+
 #include <atomic>
 #include <memory_resource>
 #include <type_traits>
 
-#ifdef _MSC_VER
-#include <new>
-#define TASKETE_L1CACHE_ALIGN alignas(std::hardware_destructive_interference_size)
-#else
-#define TASKETE_L1CACHE_ALIGN alignas(64)
-#endif
-
 namespace taskete::detail
 {
     /*
@@ -48,6 +43,8 @@ namespace taskete::detail
         ~lockfree_ringbuffer();
 
         bool try_push(T const& elem) noexcept(noexcept(std::is_nothrow_copy_assignable_v<T>));
+        // Pushes as many elements as possible, publishing them all at once
+        std::uint32_t try_push_bulk(T const* elems, std::uint32_t count) noexcept(noexcept(std::is_nothrow_copy_assignable_v<T>));
         bool try_pull(T& elem) noexcept(noexcept(std::is_nothrow_copy_assignable_v<T>));
 
         bool empty() noexcept;
@@ -99,6 +96,40 @@ namespace taskete::detail
         return true;
     }
 
+    template<typename T>
+    inline std::uint32_t lockfree_ringbuffer<T>::try_push_bulk(T const* elems, std::uint32_t count) noexcept(noexcept(std::is_nothrow_copy_assignable_v<T>))
+    {
+        auto* producer = producer_cursor.load(std::memory_order_acquire);
+        auto* consumer = consumer_cursor.load(std::memory_order_acquire);
+
+        std::uint32_t available{};
+        if (producer == consumer)
+            available = did_C_reached_P.load(std::memory_order_acquire) ? size() : 0;
+        else if (producer < consumer)
+            available = std::uint32_t(consumer - producer);
+        else
+            available = size() - std::uint32_t(producer - consumer);
+
+        auto n = count < available ? count : available;
+        if (!n)
+            return 0;
+
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            if (++producer == head + size())
+                producer = head;
+
+            *producer = elems[i];
+        }
+
+        // A single store makes every element visible to the consumer
+        producer_cursor.store(producer, std::memory_order_release);
+        if (producer == consumer_cursor.load(std::memory_order_acquire))
+            did_C_reached_P.store(false, std::memory_order_release);
+
+        return n;
+    }
+
     template<typename T>
     inline bool lockfree_ringbuffer<T>::try_pull(T& elem) noexcept(noexcept(std::is_nothrow_copy_assignable_v<T>))
     {
@@ -149,12 +180,12 @@ namespace taskete::detail
         auto* consumer = consumer_cursor.load(std::memory_order_acquire);
 
         if(producer == consumer)
-            return did_C_reached_P.load(std::memory_order_acquire) ? 0 : size();
+            return did_C_reached_P.load(std::memory_order_acquire) ? size() : 0;
             
         if (producer < consumer)
-            return consumer - producer;
+            return std::uint32_t(consumer - producer);
 
-        return size() - (consumer - producer);
+        return size() - std::uint32_t(producer - consumer);
     }
     
 }
@@ -12,4 +12,11 @@
 #else // Clang
 #define TASKETE_LIB_SYMBOLS
 #endif
+#endif
+
+#ifdef _MSC_VER
+#include <new>
+#define TASKETE_L1CACHE_ALIGN alignas(std::hardware_destructive_interference_size)
+#else
+#define TASKETE_L1CACHE_ALIGN alignas(64)
 #endif
\ No newline at end of file
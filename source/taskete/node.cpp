@@ -3,15 +3,35 @@
 taskete::detail::node::node(node&& other) noexcept
     : graph_id(other.graph_id)
     , wait_counter(other.wait_counter.load(std::memory_order_acquire))
+    , wait_count(other.wait_count)
+    , wait_start(other.wait_start)
     , exec_payload(other.exec_payload)
     , wait_list(std::move(other.wait_list))
+    , priority(other.priority)
+    , preferred_worker(other.preferred_worker)
+    , follows(other.follows)
+    , executed_by(other.executed_by)
+    , io(other.io)
+    , delay(other.delay)
+    , transient(other.transient)
+    , parent(other.parent)
+    , children(other.children.load(std::memory_order_acquire))
+    , branching(other.branching)
+    , taken(other.taken)
+    , loop(other.loop)
+    , watched(other.watched)
+    , completed_run(other.completed_run)
 {
     other.exec_payload = nullptr;
 }
 
 void taskete::detail::node::destroy(std::pmr::memory_resource* res) noexcept
 {
-    exec_payload->~execution_payload();
-    res->deallocate(exec_payload, exec_payload->size_of());
+    if (exec_payload)
+    {
+        auto payload_size = exec_payload->size_of(); // can't ask it once destroyed
+        exec_payload->~execution_payload();
+        res->deallocate(exec_payload, payload_size);
+    }
     wait_list.destroy(res);
 }
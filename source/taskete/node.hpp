@@ -1,6 +1,7 @@
 #pragma once
 
 #include <taskete/handle.hpp>
+#include <taskete/io_request.hpp>
 
 #include "execution_payload.hpp"
 
@@ -8,9 +9,60 @@
 #include <cstdint>
 #include <memory_resource>
 #include <utility>
+#include <vector>
 
 namespace taskete::detail
 {
+    // graph_id of the nodes that don't belong to a submitted graph
+    constexpr std::int32_t no_graph = -1;
+    // Affinity of the nodes that can run anywhere
+    constexpr std::int32_t no_worker = -1;
+    constexpr std::int64_t no_predecessor = -1;
+    // parent of the nodes that weren't spawned by another node
+    constexpr std::int64_t no_parent = -1;
+
+    // An edge that wasn't taken releases its successor like the others, and adds one of these to its counter
+    constexpr std::int64_t dead_edge = std::int64_t(1) << 32;
+    // Part of the counter with the predecessors still running
+    constexpr std::int64_t pending_mask = dead_edge - 1;
+
+    // Which successors a node releases as live
+    constexpr std::int32_t all_successors = -1;
+    constexpr std::int32_t no_successor = -2;
+    // Loop a condition node took, if any
+    constexpr std::int32_t no_loop = -1;
+
+    struct counter_reset
+    {
+        handle_t handle;
+        std::int64_t value;
+    };
+
+    /*
+     * Nodes on the paths from a loop's first node to its condition,
+     * and how many predecessors each of them has among them.
+     */
+    struct loop_region
+    {
+        handle_t target;
+        std::pmr::vector<counter_reset> resets;
+    };
+
+    /*
+     * What each branch of a condition node does: a value >= 0 is the index of the successor it releases,
+     * a value < 0 is -(1 + index) of the loop it takes.
+     */
+    struct branch_table
+    {
+        condition_payload* payload;
+        std::pmr::vector<std::int32_t> branches;
+        std::pmr::vector<loop_region> loops;
+
+        branch_table(std::pmr::memory_resource* res, condition_payload* payload)
+            : payload(payload), branches(res), loops(res)
+        {}
+    };
+
     template<typename T>
     class wait_list
     {
@@ -38,17 +90,59 @@ namespace taskete::detail
     {
     public:
         int32_t const graph_id;
-        std::atomic<int32_t> wait_counter;
-        execution_payload* exec_payload;
+        std::atomic<std::int64_t> wait_counter; // predecessors still running, plus a dead_edge for each branch not taken
+        std::int32_t const wait_count;          // wait_counter's initial value, restored when a graph runs again
+        std::int32_t wait_start;                // wait_counter's value when this run or loop iteration started
+        execution_payload* exec_payload; // nullptr for I/O nodes
+        fused_payload* fused = nullptr;  // same object as exec_payload, for the nodes that run a chain
         wait_list<handle_t> wait_list;
+        std::uint32_t priority = 0; // the higher, the sooner it should run
+
+        // Affinity hints, the predecessor's worker wins over the preferred one
+        std::int32_t preferred_worker = no_worker;
+        std::int64_t follows = no_predecessor;  // handle of a predecessor, we'd like to run where it ran
+        std::int32_t executed_by = no_worker;   // written before our successors are released
+
+        // Set for the nodes that execute an I/O request instead of a payload, owned by the user
+        io_request* io = nullptr;
+
+        std::int64_t delay = 0;  // steady_clock ticks between becoming ready and being dispatched
+        bool transient = false;  // destroyed by the worker as soon as it completes, only for nodes without successors
+
+        // Children spawned while the node runs, its successors are released once the last one completes
+        std::int64_t parent = no_parent;         // handle of the node that spawned us
+        std::atomic<std::int32_t> children{ 0 }; // the ones still running, plus 1 for our payload if it spawned any
+
+        // Branching, written before our successors are released
+        branch_table const* branching = nullptr; // set for condition nodes
+        std::int32_t taken = all_successors;     // successor released as live
+        std::int32_t loop = no_loop;             // taken instead of releasing the successors
+
+        // Other graphs start after this node, see graph_state::dependents
+        bool watched = false;
+        std::uint32_t completed_run = 0; // the last run of our graph we completed in, under its dependents_lock
 
         node(std::pmr::memory_resource* res, int32_t graph, int32_t wait_no, execution_payload* payload, handle_t* handle_list, std::uint32_t sz)
-            : graph_id(graph), wait_counter(wait_no), exec_payload(payload), wait_list(res, handle_list, sz)
+            : graph_id(graph), wait_counter(wait_no), wait_count(wait_no), wait_start(wait_no), exec_payload(payload), wait_list(res, handle_list, sz)
         {}
 
         node(node&& other) noexcept;
 
         void destroy(std::pmr::memory_resource* res) noexcept;
+
+        // Counts a predecessor that completed, true for the last one
+        bool release(bool live) noexcept
+        {
+            // acq_rel: we publish what we wrote, and the last one to arrive sees what the others wrote
+            auto previous = wait_counter.fetch_add(live ? -1 : dead_edge - 1, std::memory_order_acq_rel);
+            return (previous & pending_mask) == 1;
+        }
+
+        // Once ready, whether none of the edges that reached us was taken
+        bool dead() const noexcept
+        {
+            return wait_start && wait_counter.load(std::memory_order_relaxed) == wait_start * dead_edge;
+        }
     };
 
     template<typename T>
@@ -0,0 +1,472 @@
+#pragma once
+
+#include "graph.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <forward_list>
+#include <iterator>
+#include <memory_resource>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace taskete
+{
+    /// <summary>
+    /// Half-open range of indices [first, last).
+    /// </summary>
+    template<typename Index>
+    struct blocked_range
+    {
+        Index first;
+        Index last;
+
+        bool empty() const noexcept { return !(first < last); }
+        Index size() const noexcept { return empty() ? Index{} : last - first; }
+    };
+
+    // Elements below which parallel_inclusive_scan and parallel_exclusive_scan don't split a block further
+    constexpr std::size_t default_scan_block = 4096;
+
+    // Elements below which parallel_sort uses std::sort
+    constexpr std::size_t default_sort_cutoff = 8192;
+
+    namespace detail
+    {
+        // Blocks per worker of a scan, so that a slow worker doesn't hold back the others
+        constexpr std::size_t scan_blocks_per_worker = 4;
+
+        // Blocks and buckets per worker of a sort, and samples per bucket to pick the splitters from
+        constexpr std::size_t sort_blocks_per_worker = 4;
+        constexpr std::size_t sort_oversampling = 16;
+
+        /*
+         * Lazy binary splitting: the range is processed a grain at a time, and before each grain
+         * its second half is handed to a child if the executor asks for work.
+         * The first check comes before any grain, so the first split is immediate.
+         */
+        template<typename Index, typename Chunk, typename Split>
+        void split_lazily(executor& exec, Index first, Index last, Index grain, Chunk&& chunk, Split&& split)
+        {
+            while (first < last)
+            {
+                if (last - first >= grain * 2 && exec.should_split())
+                {
+                    auto middle = first + (last - first) / 2;
+                    split(middle, last);
+                    last = middle;
+                    continue;
+                }
+
+                auto end = last - first > grain ? first + grain : last;
+                chunk(first, end);
+                first = end;
+            }
+        }
+
+        template<typename Index, typename Fn>
+        void for_range(executor& exec, Fn& fn, Index first, Index last, Index grain)
+        {
+            split_lazily(exec, first, last, grain, fn, [&exec, &fn, grain](Index middle, Index end)
+            {
+                exec.spawn([&exec, &fn, middle, end, grain] { for_range(exec, fn, middle, end, grain); });
+            });
+        }
+
+        /*
+         * Result of a range, followed by the results of the ranges it handed over, the last one first:
+         * each split takes the second half of what's left, so that's also the order of the indices.
+         */
+        template<typename T>
+        struct partial_result
+        {
+            T value;
+            std::pmr::forward_list<partial_result> splits;
+
+            explicit partial_result(T const& value) : value(value)
+            {}
+        };
+
+        template<typename Index, typename T, typename Body>
+        void reduce_range(executor& exec, partial_result<T>& result, T const& identity, Body& body, Index first, Index last, Index grain)
+        {
+            auto chunk = [&result, &body](Index begin, Index end)
+            {
+                result.value = body(begin, end, std::move(result.value));
+            };
+
+            // Only the task that owns a result adds splits to it
+            split_lazily(exec, first, last, grain, chunk, [&exec, &result, &identity, &body, grain](Index middle, Index end)
+            {
+                auto& split = result.splits.emplace_front(identity);
+                exec.spawn([&exec, &split, &identity, &body, middle, end, grain] { reduce_range(exec, split, identity, body, middle, end, grain); });
+            });
+        }
+
+        // The reduction follows the tree of the splits
+        template<typename T, typename Combine>
+        T combine_results(partial_result<T>& result, Combine& combine)
+        {
+            T value = std::move(result.value);
+            for (auto& split : result.splits)
+                value = combine(std::move(value), combine_results(split, combine));
+
+            return value;
+        }
+
+        /*
+         * Two-pass blocked scan, as a graph: the blocks are reduced in parallel, a single node scans their sums
+         * into the offset of each block, then the blocks are scanned again in parallel from their offset.
+         * An exclusive scan starts from 'init', an inclusive one from the first element.
+         */
+        template<typename InputIt, typename OutputIt, typename T, typename BinaryOp>
+        void blocked_scan(executor& exec, InputIt first, InputIt last, OutputIt d_first, T const* init, BinaryOp& op, std::size_t min_block)
+        {
+            auto size = std::size_t(std::distance(first, last));
+            auto max_blocks = std::max<std::size_t>(1, exec.worker_count() * scan_blocks_per_worker);
+            min_block = std::max<std::size_t>(min_block, 1);
+            auto blocks = std::min(max_blocks, (size + min_block - 1) / min_block);
+            auto block_size = (size + blocks - 1) / blocks;
+            blocks = (size + block_size - 1) / block_size;
+
+            auto begin_of = [first, block_size](std::size_t block) { return std::next(first, std::ptrdiff_t(block * block_size)); };
+            auto end_of = [first, last, size, block_size](std::size_t block)
+            {
+                return (block + 1) * block_size >= size ? last : std::next(first, std::ptrdiff_t((block + 1) * block_size));
+            };
+
+            // sums[b] reduces block b, offsets[b] is what comes before block b, only meaningful when b > 0 or there's an init
+            std::pmr::vector<T> sums(blocks, T{});
+            std::pmr::vector<T> offsets(blocks, init ? *init : T{});
+
+            graph g{ exec };
+            auto scan_sums = g.emplace([&sums, &offsets, &op, init, blocks]
+            {
+                for (std::size_t b = 1; b < blocks; ++b)
+                    offsets[b] = (b == 1 && !init) ? sums[0] : op(offsets[b - 1], sums[b - 1]);
+            });
+
+            // The last block's sum is never used
+            for (std::size_t b = 0; b + 1 < blocks; ++b)
+            {
+                auto reduce = g.emplace([&sums, &op, b, begin_of, end_of]
+                {
+                    auto it = begin_of(b);
+                    auto end = end_of(b);
+                    T acc = *it;
+                    for (++it; it != end; ++it)
+                        acc = op(std::move(acc), *it);
+                    sums[b] = std::move(acc);
+                });
+                g.precede(reduce, scan_sums);
+            }
+
+            for (std::size_t b = 0; b < blocks; ++b)
+            {
+                auto rescan = g.emplace([&offsets, &op, init, b, begin_of, end_of, first, d_first]
+                {
+                    auto it = begin_of(b);
+                    auto end = end_of(b);
+                    auto out = std::next(d_first, std::distance(first, it));
+                    if (init)
+                    {
+                        T acc = offsets[b];
+                        for (; it != end; ++it, ++out)
+                        {
+                            T next = op(acc, *it);
+                            *out = std::move(acc);
+                            acc = std::move(next);
+                        }
+                        return;
+                    }
+
+                    T acc = b > 0 ? op(offsets[b], *it) : T(*it);
+                    *out = acc;
+                    for (++it, ++out; it != end; ++it, ++out)
+                    {
+                        acc = op(std::move(acc), *it);
+                        *out = acc;
+                    }
+                });
+                g.precede(scan_sums, rescan);
+            }
+
+            exec.submit(g);
+            exec.wait(g);
+        }
+
+        /*
+         * Quicksort that hands the upper side of each partition to a child while the executor asks for work,
+         * and lets std::sort finish what's left. The partition is 3-way, so runs of equal elements are done at once.
+         */
+        template<typename RandomIt, typename Compare>
+        void sort_partition(executor& exec, RandomIt first, RandomIt last, Compare& comp, std::size_t cutoff)
+        {
+            while (std::size_t(last - first) > cutoff && exec.should_split())
+            {
+                // Median of 3, moved to the front where the partitions don't touch it
+                auto middle = first + (last - first) / 2;
+                auto back = last - 1;
+                if (comp(*middle, *first))
+                    std::iter_swap(middle, first);
+                if (comp(*back, *middle))
+                {
+                    std::iter_swap(back, middle);
+                    if (comp(*middle, *first))
+                        std::iter_swap(middle, first);
+                }
+                std::iter_swap(first, middle);
+
+                auto less_end = std::partition(first + 1, last, [first, &comp](auto const& value) { return comp(value, *first); });
+                auto equal_end = std::partition(less_end, last, [first, &comp](auto const& value) { return !comp(*first, value); });
+                std::iter_swap(first, less_end - 1);
+
+                exec.spawn([&exec, &comp, equal_end, last, cutoff] { sort_partition(exec, equal_end, last, comp, cutoff); });
+                last = less_end - 1;
+            }
+
+            std::sort(first, last, comp);
+        }
+
+        /*
+         * Sample sort, as a graph: the blocks of the input tag each element with its bucket, a single node turns the counts
+         * into where each block writes each bucket, the blocks move their elements there in a buffer,
+         * then each bucket moves back to the same positions of the input and is sorted on its own.
+         * The splitters are compared in place, the input doesn't move before the scatter.
+         */
+        template<typename RandomIt, typename Compare>
+        void sample_sort(executor& exec, RandomIt first, RandomIt last, Compare& comp, std::size_t cutoff)
+        {
+            using value_t = typename std::iterator_traits<RandomIt>::value_type;
+
+            auto size = std::size_t(last - first);
+            auto max_blocks = std::max<std::size_t>(2, exec.worker_count() * sort_blocks_per_worker);
+            auto blocks = std::min(max_blocks, (size + cutoff - 1) / cutoff);
+            auto block_size = (size + blocks - 1) / blocks;
+            blocks = (size + block_size - 1) / block_size;
+            auto buckets = blocks;
+
+            auto at = [first](std::size_t index) { return first + std::ptrdiff_t(index); };
+
+            std::pmr::vector<RandomIt> samples(std::min(size, buckets * sort_oversampling));
+            for (std::size_t i = 0; i < samples.size(); ++i)
+                samples[i] = at(i * size / samples.size());
+            std::sort(samples.begin(), samples.end(), [&comp](RandomIt lhs, RandomIt rhs) { return comp(*lhs, *rhs); });
+
+            std::pmr::vector<RandomIt> splitters;
+            splitters.reserve(buckets - 1);
+            for (std::size_t b = 1; b < buckets; ++b)
+                splitters.push_back(samples[b * samples.size() / buckets]);
+
+            std::pmr::vector<std::uint32_t> tags(size);
+            std::pmr::vector<std::size_t> positions(blocks * buckets, 0); // the counts of each block, then where it writes each bucket
+            std::pmr::vector<std::size_t> bucket_begin(buckets + 1, 0);
+
+            auto* res = std::pmr::get_default_resource();
+            auto* buffer = static_cast<value_t*>(res->allocate(size * sizeof(value_t), alignof(value_t)));
+
+            graph g{ exec };
+            auto offsets = g.emplace([&positions, &bucket_begin, blocks, buckets]
+            {
+                std::size_t position = 0;
+                for (std::size_t b = 0; b < buckets; ++b)
+                {
+                    bucket_begin[b] = position;
+                    for (std::size_t block = 0; block < blocks; ++block)
+                    {
+                        auto count = positions[block * buckets + b];
+                        positions[block * buckets + b] = position;
+                        position += count;
+                    }
+                }
+                bucket_begin[buckets] = position;
+            });
+            auto scattered = g.emplace([] {});
+
+            for (std::size_t block = 0; block < blocks; ++block)
+            {
+                auto begin = block * block_size;
+                auto end = std::min(size, begin + block_size);
+
+                auto count = g.emplace([&comp, &splitters, &tags, &positions, at, block, buckets, begin, end]
+                {
+                    auto before = [&comp](RandomIt value, RandomIt splitter) { return comp(*value, *splitter); };
+                    for (auto i = begin; i < end; ++i)
+                    {
+                        auto bucket = std::uint32_t(std::upper_bound(splitters.begin(), splitters.end(), at(i), before) - splitters.begin());
+                        tags[i] = bucket;
+                        ++positions[block * buckets + bucket];
+                    }
+                });
+
+                auto scatter = g.emplace([&tags, &positions, at, buffer, block, buckets, begin, end]
+                {
+                    for (auto i = begin; i < end; ++i)
+                        ::new (static_cast<void*>(buffer + positions[block * buckets + tags[i]]++)) value_t(std::move(*at(i)));
+                });
+
+                g.precede(count, offsets);
+                g.precede(offsets, scatter);
+                g.precede(scatter, scattered);
+            }
+
+            for (std::size_t b = 0; b < buckets; ++b)
+            {
+                auto sort = g.emplace([&exec, &comp, &bucket_begin, at, buffer, b, cutoff]
+                {
+                    auto begin = bucket_begin[b];
+                    auto end = bucket_begin[b + 1];
+                    for (auto i = begin; i < end; ++i)
+                    {
+                        *at(i) = std::move(buffer[i]);
+                        buffer[i].~value_t();
+                    }
+
+                    sort_partition(exec, at(begin), at(end), comp, cutoff);
+                });
+                g.precede(scattered, sort);
+            }
+
+            exec.submit(g);
+            exec.wait(g);
+
+            res->deallocate(buffer, size * sizeof(value_t), alignof(value_t));
+        }
+
+        // Runs a node as the root of a fork/join, and waits for it and its children
+        template<typename Callable>
+        void fork_join(executor& exec, Callable&& c)
+        {
+            graph g{ exec };
+            g.emplace(std::forward<Callable>(c));
+
+            exec.submit(g);
+            exec.wait(g);
+        }
+    }
+
+    /// <summary>
+    /// Calls fn(first, last) on sub-ranges that cover the range, in parallel, and returns once they all returned.
+    /// A range is split in halves only while some worker is idle, and never below the grain,
+    /// so uneven costs are balanced without a fixed amount of chunks.
+    /// It can be called from a node, the worker keeps executing nodes while it waits.
+    /// </summary>
+    /// <param name="exec">Executor whose workers run the sub-ranges.</param>
+    /// <param name="range">Indices to cover.</param>
+    /// <param name="grain">Sub-ranges are at most this long, and the ranges shorter than twice this aren't split.</param>
+    /// <param name="fn">Callable that takes a sub-range's first and last index.</param>
+    template<typename Index, typename Fn>
+    void parallel_for(executor& exec, blocked_range<Index> range, Index grain, Fn&& fn)
+    {
+        if (range.empty())
+            return;
+
+        grain = std::max(grain, Index{ 1 });
+        if (range.size() <= grain)
+        {
+            fn(range.first, range.last);
+            return;
+        }
+
+        detail::fork_join(exec, [&exec, &fn, range, grain] { detail::for_range(exec, fn, range.first, range.last, grain); });
+    }
+
+    /// <summary>
+    /// Reduces a range in parallel, split like parallel_for.
+    /// Each sub-range is folded by body(first, last, accumulator), starting from the identity,
+    /// then the results are combined pairwise along the tree of the splits, in the order of the indices:
+    /// combine must be associative, but it doesn't need to be commutative.
+    /// </summary>
+    /// <param name="exec">Executor whose workers run the sub-ranges.</param>
+    /// <param name="range">Indices to reduce.</param>
+    /// <param name="grain">Sub-ranges are at most this long, and the ranges shorter than twice this aren't split.</param>
+    /// <param name="identity">Neutral element of combine, each sub-range starts from a copy.</param>
+    /// <param name="body">Callable that takes a sub-range's first and last index and an accumulator, and returns the accumulator.</param>
+    /// <param name="combine">Callable that combines 2 results, the one of the lower indices first.</param>
+    /// <returns>The reduction of the whole range, the identity if it's empty.</returns>
+    template<typename Index, typename T, typename Body, typename Combine>
+    T parallel_reduce(executor& exec, blocked_range<Index> range, Index grain, T const& identity, Body&& body, Combine&& combine)
+    {
+        if (range.empty())
+            return identity;
+
+        grain = std::max(grain, Index{ 1 });
+        if (range.size() <= grain)
+            return body(range.first, range.last, T(identity));
+
+        detail::partial_result<T> result{ identity };
+        detail::fork_join(exec, [&exec, &result, &identity, &body, range, grain]
+        {
+            detail::reduce_range(exec, result, identity, body, range.first, range.last, grain);
+        });
+
+        return detail::combine_results(result, combine);
+    }
+
+    /// <summary>
+    /// Like std::inclusive_scan: writes to d_first the reduction of each prefix of [first, last), in parallel.
+    /// The range is cut in blocks, at most a few per worker and at least min_block elements long:
+    /// the blocks are reduced in parallel, their sums are scanned, then each block is scanned from its offset.
+    /// op must be associative, it's applied about twice per element. d_first can be first.
+    /// </summary>
+    /// <param name="exec">Executor whose workers scan the blocks.</param>
+    /// <param name="op">Callable that combines 2 values, the one of the lower indices first.</param>
+    /// <returns>Past the last element written.</returns>
+    template<typename InputIt, typename OutputIt, typename BinaryOp>
+    OutputIt parallel_inclusive_scan(executor& exec, InputIt first, InputIt last, OutputIt d_first, BinaryOp op, std::size_t min_block = default_scan_block)
+    {
+        using value_t = typename std::iterator_traits<InputIt>::value_type;
+
+        auto size = std::distance(first, last);
+        if (std::size_t(size) <= min_block)
+            return std::inclusive_scan(first, last, d_first, op);
+
+        detail::blocked_scan<InputIt, OutputIt, value_t>(exec, first, last, d_first, nullptr, op, min_block);
+        return std::next(d_first, size);
+    }
+
+    /// <summary>
+    /// Like std::exclusive_scan: writes to d_first init followed by the reduction of each prefix of [first, last) but the whole range,
+    /// each one starting from init, in parallel. Blocks are made like parallel_inclusive_scan.
+    /// </summary>
+    /// <param name="exec">Executor whose workers scan the blocks.</param>
+    /// <param name="init">The first value written.</param>
+    /// <param name="op">Callable that combines 2 values, the one of the lower indices first.</param>
+    /// <returns>Past the last element written.</returns>
+    template<typename InputIt, typename OutputIt, typename T, typename BinaryOp>
+    OutputIt parallel_exclusive_scan(executor& exec, InputIt first, InputIt last, OutputIt d_first, T init, BinaryOp op, std::size_t min_block = default_scan_block)
+    {
+        auto size = std::distance(first, last);
+        if (std::size_t(size) <= min_block)
+            return std::exclusive_scan(first, last, d_first, init, op);
+
+        detail::blocked_scan(exec, first, last, d_first, &init, op, min_block);
+        return std::next(d_first, size);
+    }
+
+    /// <summary>
+    /// Sorts [first, last) in parallel, not stably, with a sample sort: the range is cut in a few blocks per worker,
+    /// the blocks distribute their elements in as many buckets split by a sorted sample, then the buckets are sorted in parallel.
+    /// A bucket keeps splitting itself while some worker is idle, so the duplicates that pile up in a bucket are still shared.
+    /// The elements only need to be movable, they're moved twice through a buffer as big as the range.
+    /// comp is called concurrently.
+    /// </summary>
+    /// <param name="exec">Executor whose workers sort the blocks.</param>
+    /// <param name="comp">Strict weak ordering, like std::sort's.</param>
+    /// <param name="cutoff">Ranges up to this long are sorted by std::sort, and blocks are never shorter.</param>
+    template<typename RandomIt, typename Compare = std::less<>>
+    void parallel_sort(executor& exec, RandomIt first, RandomIt last, Compare comp = Compare{}, std::size_t cutoff = default_sort_cutoff)
+    {
+        cutoff = std::max<std::size_t>(cutoff, 1);
+        if (!(first < last) || std::size_t(last - first) <= cutoff || exec.worker_count() < 2)
+        {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        detail::sample_sort(exec, first, last, comp, cutoff);
+    }
+}
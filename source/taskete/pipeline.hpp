@@ -0,0 +1,352 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "lock_helpers.hpp"
+#include "lockfree_ringbuffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace taskete
+{
+    enum class stage_mode : std::uint8_t
+    {
+        // One item at a time, in the order the source made them
+        serial_in_order,
+        // One item at a time, in the order they arrive
+        serial_out_of_order,
+        // Any number of items at once
+        parallel
+    };
+
+    namespace detail
+    {
+        /*
+         * Wrapper of a stage's callable, like execution_payload.
+         * The source returns false once it has nothing left, the stages ignore the result.
+         */
+        template<typename Item>
+        class stage_payload
+        {
+        public:
+            virtual bool operator()(Item& item) = 0;
+
+            virtual std::size_t size_of() const noexcept = 0;
+
+            virtual ~stage_payload()
+            {}
+        };
+
+        template<typename Item, typename Callable>
+        class stage_callable final : public stage_payload<Item>
+        {
+        private:
+            Callable c;
+
+        public:
+            explicit stage_callable(Callable&& c) : c(std::forward<Callable>(c))
+            {}
+
+            bool operator()(Item& item) override
+            {
+                if constexpr (std::is_same_v<decltype(c(item)), void>)
+                {
+                    c(item);
+                    return true;
+                }
+                else
+                    return bool(c(item));
+            }
+
+            std::size_t size_of() const noexcept override
+            {
+                return sizeof(*this);
+            }
+        };
+
+        constexpr std::uint32_t no_token = ~0u;
+
+        /*
+         * Entrance of a serial stage, for the length of a run.
+         * Out of order, the tokens queue in a ring: it's single-consumer, the owner of the stage,
+         * and the producers take turns. In order, they wait in a window indexed by their sequence number.
+         */
+        struct serial_entrance
+        {
+            lockfree_ringbuffer<std::uint32_t> ring;
+            spinlock push_lock;
+            std::atomic<std::uint32_t> pending{ 0 }; // queued or being processed, whoever makes it leave 0 owns the stage
+
+            spinlock window_lock;
+            std::pmr::vector<std::uint32_t> window;
+            std::uint64_t next = 0; // sequence number that can enter
+            bool busy = false;
+
+            serial_entrance(std::pmr::memory_resource* res, std::uint32_t tokens, bool in_order)
+                : ring(res, tokens), window(in_order ? tokens : 0, no_token, res)
+            {}
+        };
+    }
+
+    /// <summary>
+    /// Stream of items through a sequence of stages, run on an executor's workers.
+    /// At most max_tokens items are in flight: the source isn't called again until the last stage let an item go,
+    /// so a slow stage holds the whole stream back instead of letting it pile up.
+    /// The items are max_tokens Item objects allocated by run() and reused, so Item must be default-constructible:
+    /// the source overwrites what the previous item left.
+    /// </summary>
+    template<typename Item>
+    class pipeline
+    {
+    private:
+        using payload_t = detail::stage_payload<Item>;
+
+        struct stage_entry
+        {
+            stage_mode mode;
+            payload_t* payload;
+        };
+
+        std::pmr::memory_resource* res;
+        std::uint32_t max_tokens;
+        std::pmr::vector<stage_entry> stages; // the source first
+
+        struct run_state;
+
+    public:
+        /// <param name="max_tokens">How many items can be in flight at once, at least 1.</param>
+        /// <param name="res">Resource for the stages and, during a run, the items and the buffers.</param>
+        explicit pipeline(std::uint32_t max_tokens, std::pmr::memory_resource* res = std::pmr::get_default_resource())
+            : res(res), max_tokens(max_tokens ? max_tokens : 1), stages(res)
+        {
+            stages.push_back({ stage_mode::serial_in_order, nullptr });
+        }
+
+        pipeline(pipeline const&) = delete;
+        pipeline& operator=(pipeline const&) = delete;
+
+        ~pipeline()
+        {
+            for (auto& stage : stages)
+                destroy(stage.payload);
+        }
+
+        /// <summary>
+        /// Sets the callable that makes the items: it fills the item it's given and returns true,
+        /// or returns false once the stream ended. It's called by one thread at a time.
+        /// </summary>
+        template<typename Callable>
+        pipeline& source(Callable&& c)
+        {
+            destroy(stages.front().payload);
+            stages.front().payload = make(std::forward<Callable>(c));
+            return *this;
+        }
+
+        /// <summary>
+        /// Appends a stage that calls c(item) on every item.
+        /// </summary>
+        template<typename Callable>
+        pipeline& stage(stage_mode mode, Callable&& c)
+        {
+            stages.push_back({ mode, make(std::forward<Callable>(c)) });
+            return *this;
+        }
+
+        /// <summary>
+        /// Streams items until the source ends and every item went through every stage.
+        /// The caller executes nodes while it waits, it can be a node. A pipeline runs once at a time.
+        /// </summary>
+        void run(executor& exec);
+
+    private:
+        template<typename Callable>
+        payload_t* make(Callable&& c)
+        {
+            using callable_t = detail::stage_callable<Item, Callable>;
+
+            void* mem = res->allocate(sizeof(callable_t));
+            return new(mem) callable_t(std::forward<Callable>(c));
+        }
+
+        void destroy(payload_t* payload) noexcept
+        {
+            if (!payload)
+                return;
+
+            auto size = payload->size_of();
+            payload->~payload_t();
+            res->deallocate(payload, size);
+        }
+    };
+
+    /*
+     * A token is the index of an item. A task carries a token through the parallel stages itself,
+     * and leaves it at the entrance of each serial stage: if the stage is free, the task takes it over,
+     * and processes whatever queued meanwhile, handing each item but the last to a new task.
+     * After the last stage the token goes back to the source, that is the first serial stage.
+     */
+    template<typename Item>
+    struct pipeline<Item>::run_state
+    {
+        executor& exec;
+        pipeline& owner;
+        std::pmr::vector<Item> items;
+        std::pmr::vector<std::uint64_t> sequence;
+        std::pmr::deque<detail::serial_entrance> entrances; // by stage, empty for the parallel ones
+        std::uint64_t made = 0;  // only touched by the owner of the source
+        bool exhausted = false;  // same
+
+        run_state(executor& exec, pipeline& owner)
+            : exec(exec), owner(owner), items(owner.max_tokens, owner.res), sequence(owner.max_tokens, 0, owner.res), entrances(owner.res)
+        {
+            for (auto& stage : owner.stages)
+                entrances.emplace_back(owner.res, stage.mode == stage_mode::parallel ? 1u : owner.max_tokens, stage.mode == stage_mode::serial_in_order && &stage != &owner.stages.front());
+        }
+
+        payload_t& payload_of(std::size_t stage) noexcept
+        {
+            return *owner.stages[stage].payload;
+        }
+
+        // Returns false when the token is retired: the source ended
+        bool process(std::size_t stage, std::uint32_t token)
+        {
+            if (stage)
+            {
+                payload_of(stage)(items[token]);
+                return true;
+            }
+
+            if (exhausted || !payload_of(0)(items[token]))
+            {
+                exhausted = true;
+                return false;
+            }
+
+            sequence[token] = made++;
+            return true;
+        }
+
+        // The token enters a serial stage. Returns whether we own the stage now, and the token to process first
+        bool enter(std::size_t stage, std::uint32_t& token)
+        {
+            auto& entrance = entrances[stage];
+
+            if (entrance.window.empty())
+            {
+                {
+                    std::lock_guard lock{ entrance.push_lock };
+                    entrance.ring.try_push(token); // there are never more tokens than room
+                }
+
+                if (entrance.pending.fetch_add(1, std::memory_order_acq_rel))
+                    return false;
+
+                entrance.ring.try_pull(token);
+                return true;
+            }
+
+            std::lock_guard lock{ entrance.window_lock };
+            entrance.window[std::size_t(sequence[token] % owner.max_tokens)] = token;
+            return !entrance.busy && take_next(entrance, token);
+        }
+
+        // The owner of a serial stage is done with an item, and looks for the next one
+        bool leave(std::size_t stage, std::uint32_t& token)
+        {
+            auto& entrance = entrances[stage];
+
+            if (entrance.window.empty())
+            {
+                if (entrance.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    return false;
+
+                // The producer pushes before it counts itself, so the token is there
+                entrance.ring.try_pull(token);
+                return true;
+            }
+
+            std::lock_guard lock{ entrance.window_lock };
+            ++entrance.next;
+            entrance.busy = false;
+            return take_next(entrance, token);
+        }
+
+        // Under the window's lock
+        bool take_next(detail::serial_entrance& entrance, std::uint32_t& token) noexcept
+        {
+            auto& slot = entrance.window[std::size_t(entrance.next % owner.max_tokens)];
+            if (slot == detail::no_token)
+                return false;
+
+            token = std::exchange(slot, detail::no_token);
+            entrance.busy = true;
+            return true;
+        }
+
+        // Carries a token from the entrance of a stage, until it's left to somebody else or retired
+        void carry(std::uint32_t token, std::size_t stage, bool owned = false)
+        {
+            while (true)
+            {
+                if (stage == owner.stages.size())
+                    stage = 0;
+
+                if (owner.stages[stage].mode == stage_mode::parallel)
+                {
+                    process(stage, token);
+                    ++stage;
+                    continue;
+                }
+
+                if (!owned && !enter(stage, token))
+                    return;
+                owned = false;
+
+                bool alive = process(stage, token);
+                for (auto next = token; leave(stage, next); token = next)
+                {
+                    if (alive)
+                        exec.spawn([this, token, stage] { carry(token, stage + 1); });
+
+                    alive = process(stage, next);
+                }
+
+                if (!alive)
+                    return;
+
+                ++stage;
+            }
+        }
+
+        // The tokens queue at the source as if they just went through the last stage, and we own it with the first one
+        void start()
+        {
+            auto& entrance = entrances.front();
+            for (std::uint32_t token = 1; token < owner.max_tokens; ++token)
+                entrance.ring.try_push(token);
+            entrance.pending.store(owner.max_tokens, std::memory_order_relaxed);
+
+            carry(0, 0, true);
+        }
+    };
+
+    template<typename Item>
+    void pipeline<Item>::run(executor& exec)
+    {
+        if (!stages.front().payload)
+            throw std::logic_error{ "taskete::pipeline::run needs a source" };
+
+        run_state state{ exec, *this };
+        detail::fork_join(exec, [&state] { state.start(); });
+    }
+}
@@ -71,7 +71,7 @@ namespace taskete::detail
     template<typename T>
     inline constexpr handle_t pool_helper::make_handle(std::uint32_t index, T* base, T* obj) const noexcept
     {
-        return handle_t((std::uint64_t(index) << pool_shift) | obj - base);
+        return handle_t((std::uint64_t(index) << pool_shift) | std::uint64_t(obj - base));
     }
 
     inline constexpr std::uint32_t pool_helper::log2(std::uint32_t v) const noexcept
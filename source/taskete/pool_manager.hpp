@@ -37,6 +37,13 @@ namespace taskete::detail
         {}
     };
 
+    struct free_block
+    {
+        pool& owner;
+        std::uint32_t index; // of the owner among the pools
+        free_list* block;
+    };
+
     /*
      * Pool Allocator that uses handles instead of raw pointers.
      */
@@ -49,7 +56,7 @@ namespace taskete::detail
         pool_helper helper;
         std::shared_mutex rw_mutex;
 
-        std::pair<pool&, std::uint32_t> find_or_create_pool();
+        free_block take_free_block();
         void populate_list(pool& p) noexcept;
         void mark_as_free(pool& p, void* obj) noexcept;
         pool& get_pool(handle_t handle) noexcept;
@@ -68,37 +75,58 @@ namespace taskete::detail
     };
 
     /*
-     * Returns a pool with a free block.
-     * It tries to find an existing pool, otherwise it constructs a new one.
+     * Takes a free block out of a pool.
+     * It tries the existing pools, otherwise it constructs a new one.
+     *
+     * The block is taken while the pool is locked,
+     * otherwise another thread could take the last one between the check and the use.
      * 
      * Throws: bad_alloc
      *         when it can't allocate more pools
      */
     template<typename T>
-    inline std::pair<pool&, std::uint32_t> pool_manager<T>::find_or_create_pool()
+    inline free_block pool_manager<T>::take_free_block()
     {
         {
             std::shared_lock sh_lock{ rw_mutex };
-            auto it = std::find_if(std::begin(pools), std::end(pools), [](pool* p) -> bool { return p->head; });
-            if (it != std::end(pools))
-                return { **it, it - std::begin(pools) };
+            for (std::uint32_t i = 0; i < pools.size(); ++i)
+            {
+                auto& p = *pools[i];
+
+                std::unique_lock lock{ p.mtx };
+                if (p.head)
+                {
+                    auto* block = p.head;
+                    p.head = block->next;
+                    return { p, i, block };
+                }
+            }
 
             if (pools.size() == options.max_pools)
                 throw std::bad_alloc{};
         }
 
-        // Construct the new pool
+        // Construct the new pool, nobody else can see it yet
 
         auto * p = new taskete::detail::pool();
         auto * resource = pools.get_allocator().resource();
         p->raw_mem = static_cast<std::byte*>(resource->allocate(options.pool_capacity * sizeof(T), alignof(T)));
         populate_list(*p);
 
+        auto* block = p->head;
+        p->head = block->next;
+
         {
             std::unique_lock ex_lock{ rw_mutex };
-            pools.emplace_back(std::move(p));
-            auto it = --std::end(pools);
-            return { **it, it - std::begin(pools) };
+            if (pools.size() == options.max_pools) // someone else created the last one
+            {
+                resource->deallocate(p->raw_mem, options.pool_capacity * sizeof(T), alignof(T));
+                delete p;
+                throw std::bad_alloc{};
+            }
+
+            pools.emplace_back(p);
+            return { *p, std::uint32_t(pools.size() - 1), block };
         }
     }
     
@@ -165,15 +193,7 @@ namespace taskete::detail
     {
         static_assert(std::is_constructible_v<T, Args...>, "Can't construct the object with the given arguments.");
 
-        auto [pool, index] = find_or_create_pool();
-
-        free_list* free_pos{};
-
-        {
-            std::unique_lock lock{ pool.mtx };
-            free_pos = pool.head;
-            pool.head = pool.head->next;
-        }
+        auto [pool, index, free_pos] = take_free_block();
 
         return helper.make_handle(index, reinterpret_cast<T*>(pool.raw_mem), new(free_pos) T{ std::forward<Args>(args)... });
     }
@@ -183,13 +203,12 @@ namespace taskete::detail
     {
         auto& pool = get_pool(handle);
 
-        std::unique_lock lock{ pool.mtx };
         T* obj = reinterpret_cast<T*>(pool.raw_mem) + helper.extract_offset(handle);
         
         if constexpr (!std::is_trivially_destructible_v<T>)
             obj->~T();
 
-        mark_as_free(pool, obj);
+        mark_as_free(pool, obj); // locks the pool
     }
 
     template<typename T>
@@ -0,0 +1,133 @@
+#include "timing_wheel.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr std::uint32_t bits = taskete::detail::timing_wheel::level_bits;
+    constexpr std::int64_t slot_mask = taskete::detail::timing_wheel::slot_count - 1;
+    constexpr std::uint32_t levels = taskete::detail::timing_wheel::level_count;
+
+    // Ticks covered by one rotation of the given level
+    constexpr std::int64_t span_of(std::uint32_t level) noexcept
+    {
+        return std::int64_t(1) << (bits * (level + 1));
+    }
+}
+
+taskete::detail::timing_wheel::timing_wheel(std::pmr::memory_resource* res, std::int64_t now)
+    : slots(levels * slot_count, res), scratch(res), now(now) // the slots get the resource from their vector
+{}
+
+std::pmr::vector<taskete::detail::timer_entry>& taskete::detail::timing_wheel::slot(std::uint32_t level, std::int64_t tick) noexcept
+{
+    auto index = (tick >> (bits * level)) & slot_mask;
+    return slots[level * slot_count + std::size_t(index)];
+}
+
+/*
+ * An entry lands on the lowest level whose rotation reaches it,
+ * so its slot comes around for the first time exactly when it's due (level 0)
+ * or when the rotation of the level below that contains it begins.
+ */
+void taskete::detail::timing_wheel::place(timer_entry const& entry)
+{
+    auto delta = entry.due - now;
+
+    std::uint32_t level = 0;
+    while (level < levels - 1 && delta >= span_of(level))
+        ++level;
+
+    // Too far even for the last level, it will be placed again on the way
+    auto parked = std::min(entry.due, now + span_of(levels - 1) - 1);
+
+    slot(level, parked).push_back(entry);
+    ++count;
+}
+
+void taskete::detail::timing_wheel::schedule(std::int64_t due, std::uint64_t data)
+{
+    place({ std::max(due, now + 1), data });
+}
+
+/*
+ * When a rotation of a level ends, the slot of the level above that covers the next rotation is moved down.
+ * The entries due right now land in the slot of level 0 that is about to expire.
+ */
+void taskete::detail::timing_wheel::cascade(std::uint32_t level)
+{
+    scratch.clear();
+    scratch.swap(slot(level, now));
+    count -= scratch.size();
+
+    for (auto& entry : scratch)
+        place(entry);
+}
+
+void taskete::detail::timing_wheel::advance(std::int64_t tick, std::pmr::vector<std::uint64_t>& expired)
+{
+    while (now < tick)
+    {
+        if (!count)
+        {
+            now = tick;
+            return;
+        }
+
+        ++now;
+
+        for (std::uint32_t level = 1; level < levels && !(now & (span_of(level - 1) - 1)); ++level)
+            cascade(level);
+
+        auto& current = slot(0, now);
+        for (auto& entry : current)
+            expired.push_back(entry.data);
+
+        count -= current.size();
+        current.clear();
+    }
+}
+
+/*
+ * The next occupied slot of level 0 in this rotation, otherwise the end of the rotation,
+ * when something might be moved down from the levels above.
+ */
+std::int64_t taskete::detail::timing_wheel::next_expiry() const noexcept
+{
+    if (!count)
+        return no_expiry;
+
+    auto rotation_end = (now | slot_mask) + 1;
+    for (auto tick = now + 1; tick < rotation_end; ++tick)
+        if (!slots[std::size_t(tick & slot_mask)].empty())
+            return tick;
+
+    return rotation_end;
+}
+
+void taskete::detail::timing_wheel::drain(std::pmr::vector<std::uint64_t>& entries)
+{
+    for (auto& s : slots)
+    {
+        for (auto& entry : s)
+            entries.push_back(entry.data);
+        s.clear();
+    }
+
+    count = 0;
+}
+
+std::int64_t taskete::detail::timing_wheel::current() const noexcept
+{
+    return now;
+}
+
+std::uint64_t taskete::detail::timing_wheel::size() const noexcept
+{
+    return count;
+}
+
+bool taskete::detail::timing_wheel::empty() const noexcept
+{
+    return !count;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "macro_utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+namespace taskete::detail
+{
+    struct timer_entry
+    {
+        std::int64_t due; // tick
+        std::uint64_t data;
+    };
+
+    /*
+     * Hierarchical timing wheel: 4 levels of 64 slots, each slot of a level spans a whole rotation of the level below.
+     * Scheduling is O(1), and each entry is moved down at most once per level before it expires.
+     *
+     * Ticks are whatever the owner decides, the wheel only needs them to grow.
+     * Not thread-safe.
+     */
+    class TASKETE_LIB_SYMBOLS timing_wheel
+    {
+    public:
+        static constexpr std::uint32_t level_bits = 6;
+        static constexpr std::uint32_t slot_count = 1u << level_bits;
+        static constexpr std::uint32_t level_count = 4;
+
+        // What next_expiry() returns when the wheel is empty
+        static constexpr std::int64_t no_expiry = std::numeric_limits<std::int64_t>::max();
+
+    private:
+        std::pmr::vector<std::pmr::vector<timer_entry>> slots; // level by level
+        std::pmr::vector<timer_entry> scratch;                 // the slot being expired or moved down
+        std::int64_t now;
+        std::uint64_t count = 0;
+
+        std::pmr::vector<timer_entry>& slot(std::uint32_t level, std::int64_t tick) noexcept;
+        void place(timer_entry const& entry);
+        void cascade(std::uint32_t level);
+
+    public:
+        timing_wheel(std::pmr::memory_resource* res, std::int64_t now);
+
+        /*
+         * An entry that is already due expires at the next tick.
+         * Entries beyond the last level are parked in it, and rescheduled when their slot is reached.
+         */
+        void schedule(std::int64_t due, std::uint64_t data);
+
+        // Moves the wheel forward up to 'tick', and appends the data of the entries that expired
+        void advance(std::int64_t tick, std::pmr::vector<std::uint64_t>& expired);
+
+        // The first tick advance() has something to do at, it's never later than the earliest entry
+        std::int64_t next_expiry() const noexcept;
+
+        // Removes every entry, and appends its data
+        void drain(std::pmr::vector<std::uint64_t>& entries);
+
+        // Removes the entries whose data matches, and appends it
+        template<typename Predicate>
+        void extract_if(Predicate&& matches, std::pmr::vector<std::uint64_t>& extracted);
+
+        std::int64_t current() const noexcept;
+        std::uint64_t size() const noexcept;
+        bool empty() const noexcept;
+    };
+
+    template<typename Predicate>
+    inline void timing_wheel::extract_if(Predicate&& matches, std::pmr::vector<std::uint64_t>& extracted)
+    {
+        if (!count)
+            return;
+
+        for (auto& s : slots)
+        {
+            auto kept = std::remove_if(s.begin(), s.end(), [&matches, &extracted](timer_entry const& entry)
+            {
+                if (!matches(entry.data))
+                    return false;
+
+                extracted.push_back(entry.data);
+                return true;
+            });
+
+            count -= std::uint64_t(s.end() - kept);
+            s.erase(kept, s.end());
+        }
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "macro_utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <type_traits>
+
+namespace taskete::detail
+{
+    /*
+     * Fixed size
+     * Lockfree
+     * Single owner, multiple thieves
+     * Contiguous
+     *
+     * Chase-Lev deque: the owner pushes and pops at the bottom (LIFO),
+     * while any other thread can steal from the top (FIFO).
+     */
+    template<typename T>
+    class work_stealing_deque
+    {
+        static_assert(std::is_default_constructible_v<T>
+                      && std::is_trivially_copyable_v<T>
+                      , "work_stealing_deque requires a type that is DefaultConstructible and TriviallyCopyable");
+
+    private:
+        std::atomic<T>* buffer;
+        std::pmr::memory_resource* mem_res;
+        std::uint32_t _size; // always a power of 2, so we can mask the indices
+        std::int64_t mask;
+
+        TASKETE_L1CACHE_ALIGN std::atomic<std::int64_t> top;
+        TASKETE_L1CACHE_ALIGN std::atomic<std::int64_t> bottom;
+
+    public:
+        work_stealing_deque(std::pmr::memory_resource* res, std::uint32_t size);
+
+        work_stealing_deque(work_stealing_deque const&) = delete;
+        work_stealing_deque(work_stealing_deque&&) = delete;
+
+        ~work_stealing_deque();
+
+        // Owner only
+        bool try_push(T const& elem) noexcept;
+        // Owner only, pushes as many elements as possible, publishing them all at once
+        std::uint32_t try_push_bulk(T const* elems, std::uint32_t count) noexcept;
+        // Owner only
+        bool try_pop(T& elem) noexcept;
+        // Any thread
+        bool try_steal(T& elem) noexcept;
+
+        bool empty() const noexcept;
+
+        std::uint32_t size() const noexcept;
+        std::uint32_t count() const noexcept;
+    };
+
+    template<typename T>
+    inline work_stealing_deque<T>::work_stealing_deque(std::pmr::memory_resource* res, std::uint32_t size)
+    {
+        std::uint32_t capacity = 1;
+        while (capacity < size)
+            capacity <<= 1;
+
+        buffer = static_cast<std::atomic<T>*>(res->allocate(sizeof(std::atomic<T>) * capacity, alignof(std::atomic<T>)));
+        mem_res = res;
+        _size = capacity;
+        mask = std::int64_t(capacity) - 1;
+
+        for (std::uint32_t i = 0; i < capacity; ++i)
+            new(buffer + i) std::atomic<T>(T{});
+
+        top.store(0, std::memory_order_release);
+        bottom.store(0, std::memory_order_release);
+    }
+
+    template<typename T>
+    inline work_stealing_deque<T>::~work_stealing_deque()
+    {
+        mem_res->deallocate(buffer, sizeof(std::atomic<T>) * _size, alignof(std::atomic<T>));
+    }
+
+    template<typename T>
+    inline bool work_stealing_deque<T>::try_push(T const& elem) noexcept
+    {
+        auto b = bottom.load(std::memory_order_relaxed);
+        auto t = top.load(std::memory_order_acquire);
+
+        if (b - t >= std::int64_t(_size)) // full
+            return false;
+
+        buffer[b & mask].store(elem, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    template<typename T>
+    inline std::uint32_t work_stealing_deque<T>::try_push_bulk(T const* elems, std::uint32_t count) noexcept
+    {
+        auto b = bottom.load(std::memory_order_relaxed);
+        auto t = top.load(std::memory_order_acquire);
+
+        auto available = std::int64_t(_size) - (b - t);
+        auto n = std::int64_t(count) < available ? std::int64_t(count) : available;
+        if (n <= 0)
+            return 0;
+
+        for (std::int64_t i = 0; i < n; ++i)
+            buffer[(b + i) & mask].store(elems[i], std::memory_order_relaxed);
+        bottom.store(b + n, std::memory_order_release);
+
+        return std::uint32_t(n);
+    }
+
+    template<typename T>
+    inline bool work_stealing_deque<T>::try_pop(T& elem) noexcept
+    {
+        auto b = bottom.load(std::memory_order_relaxed) - 1;
+
+        // Reserve the bottom slot before looking at the thieves' cursor
+        bottom.store(b, std::memory_order_seq_cst);
+        auto t = top.load(std::memory_order_seq_cst);
+
+        if (t > b) // empty
+        {
+            bottom.store(b + 1, std::memory_order_release);
+            return false;
+        }
+
+        elem = buffer[b & mask].load(std::memory_order_relaxed);
+        if (t < b)
+            return true;
+
+        // Last element, we race against the thieves
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+
+        return won;
+    }
+
+    template<typename T>
+    inline bool work_stealing_deque<T>::try_steal(T& elem) noexcept
+    {
+        auto t = top.load(std::memory_order_seq_cst);
+        auto b = bottom.load(std::memory_order_seq_cst);
+
+        if (t >= b)
+            return false;
+
+        elem = buffer[t & mask].load(std::memory_order_relaxed);
+
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    inline bool work_stealing_deque<T>::empty() const noexcept
+    {
+        return bottom.load(std::memory_order_acquire) <= top.load(std::memory_order_acquire);
+    }
+
+    template<typename T>
+    inline std::uint32_t work_stealing_deque<T>::size() const noexcept
+    {
+        return _size;
+    }
+
+    template<typename T>
+    inline std::uint32_t work_stealing_deque<T>::count() const noexcept
+    {
+        auto b = bottom.load(std::memory_order_acquire);
+        auto t = top.load(std::memory_order_acquire);
+
+        return b > t ? std::uint32_t(b - t) : 0;
+    }
+}
@@ -0,0 +1,146 @@
+#include "../source/taskete/cpu_topology.hpp"
+#include "../source/taskete/executor.hpp"
+
+#include <doctest.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    void write_file(fs::path const& path, std::string const& content)
+    {
+        fs::create_directories(path.parent_path());
+        std::ofstream{ path } << content << '\n';
+    }
+
+    void write_cache(fs::path const& cpu_dir, int index, int level, char const* type, std::string const& shared)
+    {
+        auto cache_dir = cpu_dir / "cache" / ("index" + std::to_string(index));
+        write_file(cache_dir / "level", std::to_string(level));
+        write_file(cache_dir / "type", type);
+        write_file(cache_dir / "shared_cpu_list", shared);
+    }
+
+    /*
+     * 2 sockets, each with its own L3 and 2 L2 shared by pairs of CPUs:
+     * socket 0: {0, 1} {2, 3}
+     * socket 1: {4, 5} {6, 7}
+     */
+    fs::path make_dual_socket_sysfs()
+    {
+        auto root = fs::temp_directory_path() / "taskete_test_cpu_topology";
+        fs::remove_all(root);
+
+        write_file(root / "online", "0-7");
+        for (int cpu = 0; cpu < 8; ++cpu)
+        {
+            auto cpu_dir = root / ("cpu" + std::to_string(cpu));
+            auto pair = cpu / 2 * 2;
+            auto socket = cpu / 4;
+
+            write_file(cpu_dir / "topology" / "physical_package_id", std::to_string(socket));
+            write_cache(cpu_dir, 0, 1, "Data", std::to_string(cpu));
+            write_cache(cpu_dir, 1, 1, "Instruction", std::to_string(cpu));
+            write_cache(cpu_dir, 2, 2, "Unified", std::to_string(pair) + "-" + std::to_string(pair + 1));
+            write_cache(cpu_dir, 3, 3, "Unified", std::to_string(socket * 4) + "-" + std::to_string(socket * 4 + 3));
+        }
+
+        return root;
+    }
+}
+
+TEST_SUITE("CPU Topology")
+{
+    using taskete::detail::cpu_topology;
+
+    TEST_CASE("CPU lists are parsed")
+    {
+        auto* res = std::pmr::get_default_resource();
+
+        REQUIRE((cpu_topology::parse_cpu_list("0-3,8,10-11", res) == std::pmr::vector<std::uint32_t>{ 0, 1, 2, 3, 8, 10, 11 }));
+        REQUIRE((cpu_topology::parse_cpu_list("5", res) == std::pmr::vector<std::uint32_t>{ 5 }));
+        REQUIRE(cpu_topology::parse_cpu_list("", res).empty());
+        REQUIRE(cpu_topology::parse_cpu_list("0-a", res).empty());
+        REQUIRE(cpu_topology::parse_cpu_list("0,3-1", res).empty());
+    }
+
+    TEST_CASE("Caches and sockets are discovered")
+    {
+        auto root = make_dual_socket_sysfs();
+        auto topology = cpu_topology::discover(std::pmr::get_default_resource(), root.string());
+
+        REQUIRE(topology.size() == 8);
+        REQUIRE(topology[5].id == 5);
+        REQUIRE(topology[5].l2 == 4);
+        REQUIRE(topology[5].llc == 4);
+        REQUIRE(topology[5].package == 1);
+
+        REQUIRE(topology.distance_between(topology[0], topology[1]) == cpu_topology::same_l2);
+        REQUIRE(topology.distance_between(topology[0], topology[3]) == cpu_topology::same_llc);
+        REQUIRE(topology.distance_between(topology[0], topology[4]) == cpu_topology::remote);
+
+        fs::remove_all(root);
+    }
+
+    TEST_CASE("Only the allowed CPUs are kept")
+    {
+        auto* res = std::pmr::get_default_resource();
+        auto root = make_dual_socket_sysfs();
+        auto topology = cpu_topology::discover(res, root.string());
+
+        topology.retain({});
+        REQUIRE(topology.size() == 8);
+
+        topology.retain(cpu_topology::parse_cpu_list("1,4-5,9", res));
+        REQUIRE(topology.size() == 3);
+        REQUIRE(topology[0].id == 1);
+        REQUIRE(topology[0].l2 == 0);
+        REQUIRE(topology[2].id == 5);
+        REQUIRE(topology.distance_between(topology[1], topology[2]) == cpu_topology::same_l2);
+
+#if defined(__linux__)
+        // The calling thread runs somewhere
+        REQUIRE_FALSE(cpu_topology::allowed_cpus(res).empty());
+#endif
+
+        fs::remove_all(root);
+    }
+
+    TEST_CASE("Without sysfs the topology is empty")
+    {
+        auto topology = cpu_topology::discover(std::pmr::get_default_resource(), "/taskete/does/not/exist");
+
+        REQUIRE(topology.empty());
+    }
+
+    TEST_CASE("Pinned workers execute every node")
+    {
+        taskete::executor_options opt{};
+        opt.worker_count = 4;
+        opt.queue_capacity = 64;
+        opt.node_pool.pool_capacity = 256;
+        opt.pin_workers = true;
+
+        taskete::executor exec{ opt };
+        std::atomic<int> executed{ 0 };
+        std::vector<taskete::handle_t> handles;
+
+        for (int i = 0; i < 200; ++i)
+            handles.push_back(exec.make_node(0, nullptr, 0, [&executed] { executed.fetch_add(1, std::memory_order_relaxed); }));
+
+        for (auto h : handles)
+            exec.submit(h);
+        exec.wait_idle();
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == 200);
+
+        for (auto h : handles)
+            exec.destroy_node(h);
+    }
+}
@@ -0,0 +1,131 @@
+#include "../source/taskete/execution_policy.hpp"
+
+#include <doctest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace
+{
+    taskete::executor_options get_policy_options(std::uint32_t workers) noexcept
+    {
+        taskete::executor_options opt{};
+        opt.worker_count = workers;
+        opt.queue_capacity = 64;
+        opt.node_pool.pool_capacity = 256;
+        return opt;
+    }
+}
+
+TEST_SUITE("Execution Policy")
+{
+    TEST_CASE("for_each visits every element once")
+    {
+        constexpr std::size_t n = 100000;
+
+        taskete::executor exec{ get_policy_options(2) };
+
+        std::vector<std::uint32_t> values(n, 1);
+        std::atomic<std::uint32_t> calls{ 0 };
+
+        taskete::for_each(taskete::par(exec).with_grain(100), values.begin(), values.end(), [&calls](std::uint32_t& value)
+        {
+            value *= 3;
+            calls.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        REQUIRE(calls.load() == n);
+        REQUIRE(std::all_of(values.begin(), values.end(), [](std::uint32_t value) { return value == 3; }));
+    }
+
+    TEST_CASE("Algorithms can be called from a node")
+    {
+        constexpr std::uint64_t n = 50000;
+
+        taskete::executor exec{ get_policy_options(2) };
+
+        std::vector<std::uint64_t> values(n, 2);
+        std::uint64_t sum = 0;
+
+        taskete::graph g{ exec };
+        g.emplace([&exec, &values, &sum]
+        {
+            sum = taskete::reduce(taskete::par(exec).with_grain(100), values.begin(), values.end());
+        });
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(sum == n * 2);
+    }
+
+    TEST_CASE("transform writes every element")
+    {
+        constexpr int n = 50000;
+
+        taskete::executor exec{ get_policy_options(2) };
+
+        std::vector<int> lhs(n);
+        std::iota(lhs.begin(), lhs.end(), 0);
+        std::vector<int> rhs(n, 2);
+        std::vector<long> out(n);
+
+        auto end = taskete::transform(taskete::par(exec), lhs.begin(), lhs.end(), out.begin(), [](int value) { return long(value) * 2; });
+        REQUIRE(end == out.end());
+        for (int i = 0; i < n; ++i)
+            REQUIRE(out[std::size_t(i)] == i * 2);
+
+        taskete::transform(taskete::par(exec), lhs.begin(), lhs.end(), rhs.begin(), out.begin(), [](int l, int r) { return long(l + r); });
+        for (int i = 0; i < n; ++i)
+            REQUIRE(out[std::size_t(i)] == i + 2);
+    }
+
+    TEST_CASE("reduce and transform_reduce use init once")
+    {
+        constexpr std::uint64_t n = 200000;
+
+        taskete::executor exec{ get_policy_options(2) };
+
+        std::vector<std::uint64_t> values(n);
+        std::iota(values.begin(), values.end(), std::uint64_t(0));
+
+        auto policy = taskete::par(exec).with_grain(500);
+        REQUIRE(taskete::reduce(policy, values.begin(), values.end()) == n * (n - 1) / 2);
+        REQUIRE(taskete::reduce(policy, values.begin(), values.end(), std::uint64_t(7), std::plus<>{}) == n * (n - 1) / 2 + 7);
+        REQUIRE(taskete::transform_reduce(policy, values.begin(), values.end(), std::uint64_t(1), std::plus<>{},
+            [](std::uint64_t value) { return value % 2; }) == n / 2 + 1);
+
+        std::vector<std::uint64_t> empty;
+        REQUIRE(taskete::reduce(policy, empty.begin(), empty.end(), std::uint64_t(7), std::plus<>{}) == 7);
+    }
+
+    TEST_CASE("sort goes through parallel_sort")
+    {
+        constexpr int n = 30000;
+
+        taskete::executor exec{ get_policy_options(2) };
+
+        std::vector<int> values(n);
+        for (int i = 0; i < n; ++i)
+            values[std::size_t(i)] = (i * 7919) % n;
+
+        taskete::sort(taskete::par(exec), values.begin(), values.end(), std::greater<>{});
+
+        for (int i = 0; i < n; ++i)
+            REQUIRE(values[std::size_t(i)] == n - 1 - i);
+    }
+
+    TEST_CASE("Other iterators run serially")
+    {
+        taskete::executor exec{ get_policy_options(1) };
+
+        std::list<std::string> words{ "a", "b", "c" };
+        taskete::for_each(taskete::par(exec), words.begin(), words.end(), [](std::string& word) { word += "!"; });
+
+        REQUIRE(taskete::reduce(taskete::par(exec), words.begin(), words.end(), std::string{}, std::plus<>{}) == "a!b!c!");
+    }
+}
@@ -0,0 +1,424 @@
+#include "../source/taskete/executor.hpp"
+#include "../source/taskete/graph.hpp"
+
+#include <doctest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    taskete::executor_options get_executor_options(std::uint32_t workers) noexcept
+    {
+        taskete::executor_options opt{};
+        opt.worker_count = workers;
+        opt.queue_capacity = 64;
+        opt.node_pool.pool_capacity = 256;
+        return opt;
+    }
+}
+
+TEST_SUITE("Executor - Work Stealing")
+{
+    TEST_CASE("Uses the requested amount of workers")
+    {
+        taskete::executor exec{ get_executor_options(3) };
+
+        REQUIRE(exec.worker_count() == 3);
+    }
+
+    TEST_CASE("Every submitted node is executed exactly once")
+    {
+        constexpr int node_count = 1000;
+
+        taskete::executor exec{ get_executor_options(4) };
+        std::vector<std::atomic<int>> executed(node_count);
+        std::vector<taskete::handle_t> handles;
+
+        for (int i = 0; i < node_count; ++i)
+        {
+            executed[i].store(0, std::memory_order_relaxed);
+            handles.push_back(exec.make_node(0, nullptr, 0, [&executed, i]
+            {
+                executed[i].fetch_add(1, std::memory_order_relaxed);
+            }));
+        }
+
+        for (auto h : handles)
+            exec.submit(h);
+
+        exec.wait_idle();
+
+        for (auto& e : executed)
+            REQUIRE(e.load(std::memory_order_relaxed) == 1);
+
+        for (auto h : handles)
+            exec.destroy_node(h);
+    }
+
+    TEST_CASE("Nodes submitted from a worker are executed")
+    {
+        constexpr int children = 200; // more than a worker's queue can hold
+
+        taskete::executor exec{ get_executor_options(2) };
+        std::atomic<int> executed{ 0 };
+        std::vector<taskete::handle_t> handles;
+
+        for (int i = 0; i < children; ++i)
+            handles.push_back(exec.make_node(0, nullptr, 0, [&executed]
+            {
+                executed.fetch_add(1, std::memory_order_relaxed);
+            }));
+
+        auto parent = exec.make_node(0, nullptr, 0, [&exec, &handles]
+        {
+            for (auto h : handles)
+                exec.submit(h);
+        });
+
+        exec.submit(parent);
+        exec.wait_idle();
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == children);
+
+        exec.destroy_node(parent);
+        for (auto h : handles)
+            exec.destroy_node(h);
+    }
+
+    TEST_CASE("Idle workers steal from a busy one")
+    {
+        constexpr int children = 32;
+
+        taskete::executor exec{ get_executor_options(4) };
+        std::vector<std::thread::id> ran_on(children);
+        std::vector<taskete::handle_t> handles;
+
+        for (int i = 0; i < children; ++i)
+            handles.push_back(exec.make_node(0, nullptr, 0, [&ran_on, i]
+            {
+                ran_on[i] = std::this_thread::get_id();
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }));
+
+        // All the children land in the same worker's queue
+        auto parent = exec.make_node(0, nullptr, 0, [&exec, &handles]
+        {
+            for (auto h : handles)
+                exec.submit(h);
+        });
+
+        exec.submit(parent);
+        exec.wait_idle();
+
+        bool stolen = false;
+        for (auto& id : ran_on)
+            stolen |= id != ran_on[0];
+
+        REQUIRE(stolen);
+
+        exec.destroy_node(parent);
+        for (auto h : handles)
+            exec.destroy_node(h);
+    }
+}
+
+TEST_SUITE("Executor - Dependencies")
+{
+    TEST_CASE("A chain runs in order on the same worker")
+    {
+        constexpr int chain_length = 100;
+
+        taskete::executor exec{ get_executor_options(4) };
+        std::vector<std::thread::id> ran_on(chain_length);
+        std::vector<int> order;
+        std::vector<taskete::handle_t> handles(chain_length);
+
+        // Successors must exist before their predecessors
+        for (int i = chain_length - 1; i >= 0; --i)
+        {
+            auto* next = i + 1 < chain_length ? &handles[i + 1] : nullptr;
+            handles[i] = exec.make_node(i ? 1 : 0, next, next ? 1 : 0, [&ran_on, &order, i]
+            {
+                ran_on[i] = std::this_thread::get_id();
+                order.push_back(i);
+            });
+        }
+
+        exec.submit(handles[0]);
+        exec.wait_idle();
+
+        REQUIRE(order.size() == chain_length);
+        for (int i = 0; i < chain_length; ++i)
+        {
+            REQUIRE(order[i] == i);
+            REQUIRE((ran_on[i] == ran_on[0]));
+        }
+
+        for (auto h : handles)
+            exec.destroy_node(h);
+    }
+
+    TEST_CASE("A join runs after all its predecessors")
+    {
+        constexpr int fan_out = 50;
+
+        taskete::executor exec{ get_executor_options(4) };
+        std::atomic<int> completed{ 0 };
+        int seen_by_join = -1;
+
+        auto join = exec.make_node(fan_out, nullptr, 0, [&completed, &seen_by_join]
+        {
+            seen_by_join = completed.load(std::memory_order_relaxed);
+        });
+
+        std::vector<taskete::handle_t> middle;
+        for (int i = 0; i < fan_out; ++i)
+            middle.push_back(exec.make_node(1, &join, 1, [&completed]
+            {
+                completed.fetch_add(1, std::memory_order_relaxed);
+            }));
+
+        auto fork = exec.make_node(0, middle.data(), std::uint32_t(middle.size()), [] {});
+
+        exec.submit(fork);
+        exec.wait_idle();
+
+        REQUIRE(seen_by_join == fan_out);
+
+        exec.destroy_node(fork);
+        exec.destroy_node(join);
+        for (auto h : middle)
+            exec.destroy_node(h);
+    }
+}
+
+TEST_SUITE("Executor - Parking")
+{
+    TEST_CASE("Parked workers wake up for new work")
+    {
+        taskete::executor exec{ get_executor_options(4) };
+        std::atomic<int> executed{ 0 };
+
+        // Long enough for every worker to park
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        for (int burst = 0; burst < 3; ++burst)
+        {
+            std::vector<taskete::handle_t> handles;
+            for (int i = 0; i < 100; ++i)
+                handles.push_back(exec.make_node(0, nullptr, 0, [&executed]
+                {
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                }));
+
+            for (auto h : handles)
+                exec.submit(h);
+
+            exec.wait_idle();
+            REQUIRE(executed.load(std::memory_order_relaxed) == (burst + 1) * 100);
+
+            for (auto h : handles)
+                exec.destroy_node(h);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
+
+TEST_SUITE("Executor - Elastic")
+{
+    taskete::executor_options get_elastic_options(std::uint32_t min_workers, std::uint32_t max_workers) noexcept
+    {
+        auto opt = get_executor_options(0);
+        opt.elastic.enabled = true;
+        opt.elastic.min_workers = min_workers;
+        opt.elastic.max_workers = max_workers;
+        opt.elastic.grow_threshold = 1;
+        opt.elastic.grow_after = std::chrono::milliseconds(1);
+        opt.elastic.retire_after = std::chrono::milliseconds(20);
+        return opt;
+    }
+
+    // Submits nodes that keep a worker busy for a while, returns the most workers seen running
+    std::uint32_t run_busy_nodes(taskete::executor& exec, int count)
+    {
+        std::atomic<std::uint32_t> peak{ 0 };
+        std::vector<taskete::handle_t> handles;
+
+        for (int i = 0; i < count; ++i)
+            handles.push_back(exec.make_node(0, nullptr, 0, [&exec, &peak]
+            {
+                auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(200);
+                while (std::chrono::steady_clock::now() < end)
+                    std::this_thread::yield();
+
+                auto workers = exec.worker_count();
+                auto current = peak.load(std::memory_order_relaxed);
+                while (workers > current && !peak.compare_exchange_weak(current, workers, std::memory_order_relaxed));
+            }));
+
+        for (auto h : handles)
+            exec.submit(h);
+        exec.wait_idle();
+
+        for (auto h : handles)
+            exec.destroy_node(h);
+
+        return peak.load(std::memory_order_relaxed);
+    }
+
+    TEST_CASE("Starts with the minimum amount of workers")
+    {
+        taskete::executor exec{ get_elastic_options(2, 4) };
+
+        REQUIRE(exec.worker_count() == 2);
+    }
+
+    TEST_CASE("Grows while the queues stay deep, up to the maximum")
+    {
+        taskete::executor exec{ get_elastic_options(1, 4) };
+
+        auto peak = run_busy_nodes(exec, 500);
+
+        REQUIRE(peak > 1);
+        REQUIRE(peak <= 4);
+    }
+
+    TEST_CASE("Idle workers retire down to the minimum")
+    {
+        taskete::executor exec{ get_elastic_options(1, 4) };
+
+        REQUIRE(run_busy_nodes(exec, 500) > 1);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (exec.worker_count() > 1 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        REQUIRE(exec.worker_count() == 1);
+
+        // Retired workers can be spawned again
+        REQUIRE(run_busy_nodes(exec, 500) > 1);
+    }
+}
+
+TEST_SUITE("Executor - Spawning")
+{
+    TEST_CASE("Only a running node can spawn children")
+    {
+        taskete::executor exec{ get_executor_options(1) };
+
+        REQUIRE_THROWS_AS(exec.spawn([] {}), std::logic_error);
+    }
+
+    TEST_CASE("A node's children and grandchildren are all executed")
+    {
+        constexpr int fan_out = 8;
+
+        taskete::executor exec{ get_executor_options(2) };
+        std::atomic<int> executed{ 0 };
+
+        auto root = exec.make_node(0, nullptr, 0, [&exec, &executed]
+        {
+            for (int i = 0; i < fan_out; ++i)
+            {
+                exec.spawn([&exec, &executed]
+                {
+                    executed.fetch_add(1, std::memory_order_relaxed);
+                    for (int j = 0; j < fan_out; ++j)
+                        exec.spawn([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+                });
+            }
+        });
+        exec.get_node(root).transient = true;
+
+        exec.submit(root);
+        exec.wait_idle();
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == fan_out + fan_out * fan_out);
+    }
+}
+
+TEST_SUITE("Executor - Periodic Submission")
+{
+    TEST_CASE("A callable runs every period until it's cancelled")
+    {
+        taskete::executor exec{ get_executor_options(2) };
+        std::atomic<int> runs{ 0 };
+
+        auto periodic = exec.submit_every(std::chrono::milliseconds(2), [&runs] { runs.fetch_add(1, std::memory_order_relaxed); });
+
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (runs.load(std::memory_order_relaxed) < 5 && std::chrono::steady_clock::now() < until)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        exec.cancel_every(periodic);
+        exec.wait_idle();
+        auto seen = runs.load(std::memory_order_relaxed);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        REQUIRE(seen >= 5);
+        REQUIRE(runs.load(std::memory_order_relaxed) == seen);
+    }
+
+    TEST_CASE("A run is skipped while the previous one is going")
+    {
+        taskete::executor exec{ get_executor_options(2) };
+        std::atomic<int> running{ 0 };
+        std::atomic<int> overlaps{ 0 };
+        std::atomic<int> runs{ 0 };
+
+        exec.submit_every(std::chrono::milliseconds(1), [&]
+        {
+            if (running.fetch_add(1, std::memory_order_seq_cst))
+                overlaps.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            running.fetch_sub(1, std::memory_order_seq_cst);
+            runs.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        // The executor stops the task on its way out
+        REQUIRE(overlaps.load(std::memory_order_relaxed) == 0);
+        REQUIRE(runs.load(std::memory_order_relaxed) <= 11);
+    }
+
+    TEST_CASE("A graph that outlasts its period isn't submitted again before it completed")
+    {
+        taskete::executor exec{ get_executor_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<int> running{ 0 };
+        std::atomic<int> overlaps{ 0 };
+        std::atomic<int> runs{ 0 };
+
+        auto first = g.emplace([&]
+        {
+            if (running.fetch_add(1, std::memory_order_seq_cst))
+                overlaps.fetch_add(1, std::memory_order_relaxed);
+        });
+        auto last = g.emplace([&]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            running.fetch_sub(1, std::memory_order_seq_cst);
+            runs.fetch_add(1, std::memory_order_relaxed);
+        });
+        g.precede(first, last);
+
+        auto periodic = exec.submit_every(std::chrono::milliseconds(1), g);
+
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (runs.load(std::memory_order_relaxed) < 3 && std::chrono::steady_clock::now() < until)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        exec.cancel_every(periodic);
+        exec.wait_idle();
+
+        REQUIRE(runs.load(std::memory_order_relaxed) >= 3);
+        REQUIRE(overlaps.load(std::memory_order_relaxed) == 0);
+    }
+}
@@ -0,0 +1,1473 @@
+#include "../source/taskete/graph.hpp"
+
+#include <doctest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    taskete::executor_options get_graph_options(std::uint32_t workers, taskete::scheduling_mode mode = taskete::scheduling_mode::fifo) noexcept
+    {
+        taskete::executor_options opt{};
+        opt.worker_count = workers;
+        opt.queue_capacity = 64;
+        opt.node_pool.pool_capacity = 256;
+        opt.scheduling = mode;
+        return opt;
+    }
+}
+
+TEST_SUITE("Graph - Construction")
+{
+    TEST_CASE("A graph that is never submitted cleans up its nodes")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+
+        auto a = g.emplace([] {});
+        auto b = g.emplace([](int) {}, 4);
+        g.precede(a, b);
+
+        REQUIRE(g.size() == 2);
+        REQUIRE_FALSE(g.submitted());
+    }
+
+    TEST_CASE("A graph with a cycle can't be submitted")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+
+        auto a = g.emplace([] {});
+        auto b = g.emplace([] {});
+        auto c = g.emplace([] {});
+        g.precede(a, b).precede(b, c).precede(c, a);
+
+        REQUIRE_THROWS_AS(exec.submit(g), std::logic_error);
+        REQUIRE_FALSE(g.submitted());
+    }
+
+    TEST_CASE("A node can only follow one of its predecessors")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+
+        auto a = g.emplace([] {});
+        auto b = g.emplace([] {});
+        g.follow(b, a);
+
+        REQUIRE_THROWS_AS(exec.submit(g), std::logic_error);
+    }
+
+    TEST_CASE("A graph can't be submitted again while it's running")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        std::atomic<bool> go{ false };
+
+        g.emplace([&go]
+        {
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        });
+
+        exec.submit(g);
+
+        REQUIRE(g.submitted());
+        REQUIRE_THROWS_AS(exec.submit(g), std::logic_error);
+
+        go.store(true, std::memory_order_release);
+        exec.wait(g);
+    }
+}
+
+TEST_SUITE("Graph - Resubmission")
+{
+    TEST_CASE("A completed graph runs again on the same nodes")
+    {
+        constexpr int runs = 50;
+
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::vector<int> order;
+        std::atomic<int> joined{ 0 };
+
+        // a -> {b, c} -> d
+        auto a = g.emplace([&order] { order.push_back(0); });
+        auto b = g.emplace([&joined] { joined.fetch_add(1, std::memory_order_relaxed); });
+        auto c = g.emplace([&joined] { joined.fetch_add(1, std::memory_order_relaxed); });
+        auto d = g.emplace([&order, &joined] { order.push_back(joined.load(std::memory_order_relaxed)); });
+        g.precede(a, b).precede(a, c).precede(b, d).precede(c, d);
+
+        for (int i = 0; i < runs; ++i)
+        {
+            exec.submit(g);
+            exec.wait(g);
+        }
+
+        REQUIRE(order.size() == 2 * runs);
+        for (int i = 0; i < runs; ++i)
+        {
+            REQUIRE(order[2 * std::size_t(i)] == 0);
+            REQUIRE(order[2 * std::size_t(i) + 1] == 2 * (i + 1));
+        }
+    }
+
+    TEST_CASE("A cancelled run doesn't affect the next one")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        std::atomic<int> executed{ 0 };
+        bool cancel = true;
+
+        auto a = g.emplace([&g, &cancel]
+        {
+            if (cancel)
+                g.cancel();
+        });
+        g.precede(a, g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); }));
+
+        exec.submit(g);
+        exec.wait(g);
+        REQUIRE(executed.load(std::memory_order_relaxed) == 0);
+
+        cancel = false;
+        exec.submit(g);
+        exec.wait(g);
+        REQUIRE(executed.load(std::memory_order_relaxed) == 1);
+    }
+
+    TEST_CASE("A submitted graph can't change its nodes")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        taskete::io_request request{};
+
+        auto a = g.emplace([] {});
+        auto b = g.emplace([] {});
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE_THROWS_AS(g.emplace([] {}), std::logic_error);
+        REQUIRE_THROWS_AS(g.emplace_condition([] { return 0; }), std::logic_error);
+        REQUIRE_THROWS_AS(g.emplace_io(request), std::logic_error);
+        REQUIRE_THROWS_AS(g.precede(a, b), std::logic_error);
+        REQUIRE_THROWS_AS(g.delay(a, std::chrono::milliseconds(1)), std::logic_error);
+        REQUIRE(g.size() == 2);
+
+        // The graph itself can still be tuned between runs
+        g.max_workers(1).share(2);
+        exec.submit(g);
+        exec.wait(g);
+    }
+}
+
+TEST_SUITE("Graph - Chain Fusion")
+{
+    taskete::executor_options get_fusion_options(std::uint32_t workers) noexcept
+    {
+        auto opt = get_graph_options(workers);
+        opt.fuse_chains = true;
+        return opt;
+    }
+
+    TEST_CASE("A chain runs in order on a single worker")
+    {
+        constexpr int chain_length = 50;
+
+        taskete::executor exec{ get_fusion_options(2) };
+        taskete::graph g{ exec };
+        std::vector<int> order;
+        std::vector<std::thread::id> threads;
+
+        auto prev = g.emplace([&order, &threads] { order.push_back(0); threads.push_back(std::this_thread::get_id()); });
+        for (int i = 1; i < chain_length; ++i)
+        {
+            auto next = g.emplace([&order, &threads, i] { order.push_back(i); threads.push_back(std::this_thread::get_id()); });
+            g.precede(prev, next);
+            prev = next;
+        }
+
+        // Twice, the fused node is reused
+        for (int run = 0; run < 2; ++run)
+        {
+            order.clear();
+            threads.clear();
+
+            exec.submit(g);
+            exec.wait(g);
+
+            REQUIRE(order.size() == chain_length);
+            for (int i = 0; i < chain_length; ++i)
+            {
+                REQUIRE(order[std::size_t(i)] == i);
+                REQUIRE((threads[std::size_t(i)] == threads.front()));
+            }
+        }
+    }
+
+    TEST_CASE("Branches, joins and delays end the chains")
+    {
+        taskete::executor exec{ get_fusion_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<int> before_join{ 0 };
+        int seen_by_join = 0;
+        std::chrono::steady_clock::time_point released{}, delayed{};
+
+        // a -> {b -> c, d} -> e -> f (delayed)
+        auto a = g.emplace([] {});
+        auto b = g.emplace([&before_join] { before_join.fetch_add(1, std::memory_order_relaxed); });
+        auto c = g.emplace([&before_join] { before_join.fetch_add(1, std::memory_order_relaxed); });
+        auto d = g.emplace([&before_join] { before_join.fetch_add(1, std::memory_order_relaxed); });
+        auto e = g.emplace([&before_join, &seen_by_join, &released]
+        {
+            seen_by_join = before_join.load(std::memory_order_relaxed);
+            released = std::chrono::steady_clock::now();
+        });
+        auto f = g.emplace([&delayed] { delayed = std::chrono::steady_clock::now(); });
+        g.precede(a, b).precede(b, c).precede(a, d).precede(c, e).precede(d, e).precede(e, f);
+        g.delay(f, std::chrono::milliseconds(20));
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(seen_by_join == 3);
+        REQUIRE(delayed - released >= std::chrono::milliseconds(20));
+    }
+
+    TEST_CASE("A fused chain stops once the graph is cancelled")
+    {
+        constexpr int chain_length = 20;
+
+        taskete::executor exec{ get_fusion_options(1) };
+        taskete::graph g{ exec };
+        std::atomic<int> executed{ 0 };
+
+        auto prev = g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+        for (int i = 1; i < chain_length; ++i)
+        {
+            auto next = g.emplace([&g, &executed, i]
+            {
+                executed.fetch_add(1, std::memory_order_relaxed);
+                if (i == chain_length / 2)
+                    g.cancel();
+            });
+            g.precede(prev, next);
+            prev = next;
+        }
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == chain_length / 2 + 1);
+    }
+}
+
+TEST_SUITE("Graph - Edge Reduction")
+{
+    taskete::executor_options get_reduction_options(std::uint32_t workers) noexcept
+    {
+        auto opt = get_graph_options(workers);
+        opt.reduce_edges = true;
+        return opt;
+    }
+
+    TEST_CASE("Redundant and duplicated edges don't change the order")
+    {
+        taskete::executor exec{ get_reduction_options(2) };
+        taskete::graph g{ exec };
+        std::vector<int> order;
+
+        // a -> b -> c, with a -> c implied and b -> c declared twice
+        auto a = g.emplace([&order] { order.push_back(0); });
+        auto b = g.emplace([&order] { order.push_back(1); });
+        auto c = g.emplace([&order] { order.push_back(2); });
+        g.precede(a, c).precede(a, b).precede(b, c).precede(b, c);
+
+        for (int run = 0; run < 2; ++run)
+        {
+            order.clear();
+            exec.submit(g);
+            exec.wait(g);
+
+            REQUIRE(order == std::vector<int>{ 0, 1, 2 });
+        }
+    }
+
+    TEST_CASE("Large graphs keep every declared order")
+    {
+        constexpr std::uint32_t node_count = 5000;
+
+        taskete::executor exec{ get_reduction_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<std::uint32_t> clock{ 0 };
+        std::vector<std::uint32_t> completed(node_count);
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+
+        for (std::uint32_t i = 0; i < node_count; ++i)
+            g.emplace([&clock, &completed, i] { completed[i] = clock.fetch_add(1, std::memory_order_relaxed); });
+
+        // Every node comes after the previous one, so the other edges are all redundant
+        std::uint32_t seed = 12345;
+        for (std::uint32_t i = 1; i < node_count; ++i)
+        {
+            edges.emplace_back(i - 1, i);
+            for (int extra = 0; extra < 3; ++extra)
+            {
+                seed = seed * 1103515245 + 12345;
+                edges.emplace_back((seed >> 8) % i, i);
+            }
+        }
+        for (auto [before, after] : edges)
+            g.precede(before, after);
+
+        exec.submit(g);
+        exec.wait(g);
+
+        for (auto [before, after] : edges)
+            REQUIRE(completed[before] < completed[after]);
+    }
+
+    TEST_CASE("A large graph submitted from a worker is reduced on the pool")
+    {
+        constexpr std::uint32_t node_count = 5000;
+
+        // The lanes of the reduction run on the pool, the submitting node helps with them while it waits
+        taskete::executor exec{ get_reduction_options(2) };
+        taskete::graph g{ exec };
+        std::vector<std::uint32_t> order;
+
+        for (std::uint32_t i = 0; i < node_count; ++i)
+            g.emplace([&order, i] { order.push_back(i); });
+        for (std::uint32_t i = 2; i < node_count; ++i)
+            g.precede(i - 2, i).precede(i - 1, i);
+        g.precede(0, 1);
+
+        taskete::graph outer{ exec };
+        outer.emplace([&exec, &g]
+        {
+            exec.submit(g);
+            exec.wait(g);
+        });
+
+        exec.submit(outer);
+        exec.wait(outer);
+
+        REQUIRE(order.size() == node_count);
+        for (std::uint32_t i = 0; i < node_count; ++i)
+            REQUIRE(order[i] == i);
+    }
+}
+
+TEST_SUITE("Graph - Dynamic Children")
+{
+    // Sums [first, last) splitting it in halves, each half is a child
+    void spawn_sum(taskete::executor& exec, std::atomic<std::uint64_t>& total, std::uint64_t first, std::uint64_t last)
+    {
+        if (last - first <= 16)
+        {
+            std::uint64_t sum = 0;
+            for (auto i = first; i < last; ++i)
+                sum += i;
+            total.fetch_add(sum, std::memory_order_relaxed);
+            return;
+        }
+
+        auto middle = first + (last - first) / 2;
+        exec.spawn([&exec, &total, first, middle] { spawn_sum(exec, total, first, middle); });
+        exec.spawn([&exec, &total, middle, last] { spawn_sum(exec, total, middle, last); });
+    }
+
+    TEST_CASE("Successors wait for every child")
+    {
+        constexpr int child_count = 16;
+
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<int> children{ 0 };
+        int seen = 0;
+
+        auto parent = g.emplace([&exec, &children]
+        {
+            for (int i = 0; i < child_count; ++i)
+            {
+                exec.spawn([&children]
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    children.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        });
+        g.precede(parent, g.emplace([&children, &seen] { seen = children.load(std::memory_order_relaxed); }));
+
+        // Twice, the join counter is back to 0 once the children completed
+        for (int run = 0; run < 2; ++run)
+        {
+            children.store(0, std::memory_order_relaxed);
+            exec.submit(g);
+            exec.wait(g);
+
+            REQUIRE(seen == child_count);
+        }
+    }
+
+    TEST_CASE("Recursive splits complete before the successors")
+    {
+        constexpr std::uint64_t n = 10000;
+
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<std::uint64_t> total{ 0 };
+        std::uint64_t seen = 0;
+
+        auto split = g.emplace([&exec, &total] { spawn_sum(exec, total, 0, n); });
+        g.precede(split, g.emplace([&total, &seen] { seen = total.load(std::memory_order_relaxed); }));
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(seen == n * (n - 1) / 2);
+    }
+
+    TEST_CASE("In a fused chain, the next node waits for the children of the previous one")
+    {
+        constexpr int child_count = 8;
+
+        auto options = get_graph_options(2);
+        options.fuse_chains = true;
+        taskete::executor exec{ options };
+        taskete::graph g{ exec };
+        std::atomic<int> children{ 0 };
+        std::vector<int> seen;
+
+        auto spawner = [&exec, &children, &seen]
+        {
+            seen.push_back(children.load(std::memory_order_relaxed));
+            for (int i = 0; i < child_count; ++i)
+            {
+                exec.spawn([&children]
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    children.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        };
+
+        // a -> b -> c -> d, fused, each but d spawns
+        auto a = g.emplace(spawner);
+        auto b = g.emplace(spawner);
+        auto c = g.emplace(spawner);
+        auto d = g.emplace([&children, &seen] { seen.push_back(children.load(std::memory_order_relaxed)); });
+        g.precede(a, b).precede(b, c).precede(c, d);
+
+        // Twice, the chain starts over from its first node
+        for (int run = 0; run < 2; ++run)
+        {
+            children.store(0, std::memory_order_relaxed);
+            seen.clear();
+
+            exec.submit(g);
+            exec.wait(g);
+
+            REQUIRE(seen == std::vector<int>{ 0, child_count, 2 * child_count, 3 * child_count });
+        }
+    }
+}
+
+TEST_SUITE("Graph - Conditions")
+{
+    TEST_CASE("Only the branch taken runs, joins still run")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<int> then_runs{ 0 }, else_runs{ 0 }, joined{ 0 };
+        int pick = 1;
+
+        // cond -> {then -> then_tail, else} -> join
+        auto cond = g.emplace_condition([&pick] { return pick; });
+        auto then_node = g.emplace([&then_runs] { then_runs.fetch_add(1, std::memory_order_relaxed); });
+        auto then_tail = g.emplace([&then_runs] { then_runs.fetch_add(1, std::memory_order_relaxed); });
+        auto else_node = g.emplace([&else_runs] { else_runs.fetch_add(1, std::memory_order_relaxed); });
+        auto join = g.emplace([&joined] { joined.fetch_add(1, std::memory_order_relaxed); });
+        g.precede(cond, then_node).precede(cond, else_node).precede(then_node, then_tail);
+        g.precede(then_tail, join).precede(else_node, join);
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(then_runs.load(std::memory_order_relaxed) == 0);
+        REQUIRE(else_runs.load(std::memory_order_relaxed) == 1);
+        REQUIRE(joined.load(std::memory_order_relaxed) == 1);
+
+        pick = 0;
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(then_runs.load(std::memory_order_relaxed) == 2);
+        REQUIRE(else_runs.load(std::memory_order_relaxed) == 1);
+        REQUIRE(joined.load(std::memory_order_relaxed) == 2);
+    }
+
+    TEST_CASE("An index past the last branch skips every successor")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        std::atomic<int> executed{ 0 };
+
+        auto cond = g.emplace_condition([] { return -1; });
+        auto a = g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+        auto b = g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+        g.precede(cond, a).precede(a, b).delay(b, std::chrono::seconds(10));
+
+        auto start = std::chrono::steady_clock::now();
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == 0);
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    }
+
+    void check_loop(taskete::executor_options const& opt)
+    {
+        constexpr int iterations = 10;
+
+        taskete::executor exec{ opt };
+        taskete::graph g{ exec };
+        int counter = 0;
+        std::vector<int> trace;
+
+        // init -> first -> second -> cond -> done, with init -> second too and cond looping back to first
+        auto init = g.emplace([&counter, &trace] { counter = 0; trace.clear(); });
+        auto first = g.emplace([&trace] { trace.push_back(1); });
+        auto second = g.emplace([&counter, &trace] { ++counter; trace.push_back(2); });
+        auto cond = g.emplace_condition([&counter] { return counter < iterations ? 1 : 0; });
+        auto done = g.emplace([&trace] { trace.push_back(0); });
+        g.precede(init, first).precede(init, second).precede(first, second).precede(second, cond);
+        g.precede(cond, done).loop_back(cond, first);
+
+        // Twice, the loop's counters are restored for the new run
+        for (int run = 0; run < 2; ++run)
+        {
+            exec.submit(g);
+            exec.wait(g);
+
+            REQUIRE(counter == iterations);
+            REQUIRE(trace.size() == 2 * iterations + 1);
+            for (std::size_t i = 0; i < 2 * iterations; ++i)
+                REQUIRE(trace[i] == int(i % 2) + 1);
+            REQUIRE(trace.back() == 0);
+        }
+    }
+
+    TEST_CASE("A loop runs its body until the condition exits")
+    {
+        check_loop(get_graph_options(2));
+    }
+
+    TEST_CASE("Loops work with edge reduction and chain fusion")
+    {
+        auto opt = get_graph_options(2);
+        opt.reduce_edges = true;
+        opt.fuse_chains = true;
+        check_loop(opt);
+    }
+
+    TEST_CASE("A branch not taken in a loop is skipped even if an edge from outside reached it")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        int iteration = 0;
+        std::string trace;
+
+        // init -> a -> pick -> {b, d} -> cond -> end, with init -> b too and cond looping back to a
+        auto init = g.emplace([&trace] { trace += 'i'; });
+        auto a = g.emplace([&iteration, &trace] { ++iteration; trace += 'a'; });
+        auto pick = g.emplace_condition([&iteration, &trace] { trace += 'p'; return iteration == 1 ? 0 : 1; });
+        auto b = g.emplace([&trace] { trace += 'b'; });
+        auto d = g.emplace([&trace] { trace += 'd'; });
+        auto cond = g.emplace_condition([&iteration, &trace] { trace += 'c'; return iteration < 2 ? 1 : 0; });
+        auto end = g.emplace([&trace] { trace += 'e'; });
+        g.precede(init, a).precede(init, b).precede(a, pick).precede(pick, b).precede(pick, d);
+        g.precede(b, cond).precede(d, cond).precede(cond, end).loop_back(cond, a);
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(trace == "iapbcapdce");
+    }
+
+    TEST_CASE("Loops must start before their condition and exit only through it")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+
+        taskete::graph unordered{ exec };
+        auto cond = unordered.emplace_condition([] { return 0; });
+        auto after = unordered.emplace([] {});
+        unordered.precede(cond, after).loop_back(cond, after);
+        REQUIRE_THROWS_AS(exec.submit(unordered), std::logic_error);
+
+        taskete::graph leaky{ exec };
+        auto body = leaky.emplace([] {});
+        auto side = leaky.emplace([] {});
+        auto check = leaky.emplace_condition([] { return 0; });
+        leaky.precede(body, side).precede(body, check).loop_back(check, body);
+        REQUIRE_THROWS_AS(exec.submit(leaky), std::logic_error);
+    }
+}
+
+TEST_SUITE("Graph - Execution")
+{
+    TEST_CASE("Nodes run after their predecessors")
+    {
+        taskete::executor exec{ get_graph_options(4) };
+        taskete::graph g{ exec };
+
+        constexpr int layers = 10;
+        constexpr int width = 8;
+
+        std::vector<std::atomic<int>> done(layers * width);
+        for (auto& d : done)
+            d.store(0, std::memory_order_relaxed);
+        std::atomic<bool> ordered{ true };
+
+        std::vector<taskete::graph::node_id> ids;
+        for (int l = 0; l < layers; ++l)
+            for (int w = 0; w < width; ++w)
+                ids.push_back(g.emplace([&done, &ordered, l, w]
+                {
+                    if (l)
+                        for (int prev = 0; prev < width; ++prev)
+                            if (!done[(l - 1) * width + prev].load(std::memory_order_acquire))
+                                ordered.store(false, std::memory_order_relaxed);
+
+                    done[l * width + w].store(1, std::memory_order_release);
+                }));
+
+        for (int l = 1; l < layers; ++l)
+            for (int w = 0; w < width; ++w)
+                for (int prev = 0; prev < width; ++prev)
+                    g.precede(ids[(l - 1) * width + prev], ids[l * width + w]);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(ordered.load(std::memory_order_relaxed));
+        for (auto& d : done)
+            REQUIRE(d.load(std::memory_order_relaxed) == 1);
+    }
+}
+
+TEST_SUITE("Graph - Bulk Submission")
+{
+    TEST_CASE("More roots than the queues can hold")
+    {
+        constexpr int roots = 1000; // 4 inboxes of 64 elements
+
+        taskete::executor exec{ get_graph_options(4) };
+        taskete::graph g{ exec };
+        std::atomic<int> executed{ 0 };
+
+        auto join = g.emplace([] {});
+        for (int i = 0; i < roots; ++i)
+            g.precede(g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); }), join);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == roots);
+    }
+
+    TEST_CASE("Roots submitted from a worker")
+    {
+        constexpr int roots = 200;
+
+        taskete::executor exec{ get_graph_options(4) };
+        taskete::graph inner{ exec };
+        taskete::graph outer{ exec };
+        std::atomic<int> executed{ 0 };
+
+        for (int i = 0; i < roots; ++i)
+            inner.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+
+        outer.emplace([&exec, &inner] { exec.submit(inner); });
+
+        exec.submit(outer);
+        exec.wait_idle();
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == roots);
+    }
+}
+
+TEST_SUITE("Graph - Waiting")
+{
+    TEST_CASE("Waiting for a graph that wasn't submitted returns right away")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        g.emplace([] {});
+
+        exec.wait(g);
+
+        REQUIRE_FALSE(g.submitted());
+    }
+
+    TEST_CASE("The caller executes nodes while it waits")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        std::atomic<bool> started{ false };
+        std::atomic<bool> unblocked{ false };
+
+        // Keeps the only worker busy until the graph runs
+        auto blocker = exec.make_node(0, nullptr, 0, [&started, &unblocked]
+        {
+            started.store(true, std::memory_order_release);
+            while (!unblocked.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        });
+        exec.submit(blocker);
+
+        while (!started.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        std::thread::id executed_by{};
+        taskete::graph g{ exec };
+        g.emplace([&executed_by, &unblocked]
+        {
+            executed_by = std::this_thread::get_id();
+            unblocked.store(true, std::memory_order_release);
+        });
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE((executed_by == std::this_thread::get_id()));
+
+        exec.wait_idle();
+        exec.destroy_node(blocker);
+    }
+
+    TEST_CASE("Nodes can wait for nested graphs")
+    {
+        constexpr int outer_nodes = 8;
+        constexpr int inner_nodes = 16;
+
+        // Fewer workers than nodes waiting at the same time
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph outer{ exec };
+        std::atomic<int> executed{ 0 };
+
+        for (int i = 0; i < outer_nodes; ++i)
+        {
+            outer.emplace([&exec, &executed]
+            {
+                taskete::graph inner{ exec };
+                for (int j = 0; j < inner_nodes; ++j)
+                    inner.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+
+                exec.submit(inner);
+                exec.wait(inner);
+            });
+        }
+
+        exec.submit(outer);
+        exec.wait(outer);
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == outer_nodes * inner_nodes);
+    }
+}
+
+TEST_SUITE("Graph - Deadlines")
+{
+    // Keeps the only worker busy until 'go' is set
+    void block_worker(taskete::executor& exec, std::unique_ptr<taskete::graph>& blocker, std::atomic<bool>& go)
+    {
+        std::atomic<bool> started{ false };
+
+        blocker = std::make_unique<taskete::graph>(exec);
+        blocker->emplace([&started, &go]
+        {
+            started.store(true, std::memory_order_release);
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        });
+        exec.submit(*blocker);
+
+        while (!started.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("The earliest deadline is dispatched first")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        std::unique_ptr<taskete::graph> blocker;
+        std::atomic<bool> go{ false };
+        std::vector<char> order;
+
+        block_worker(exec, blocker, go);
+
+        auto now = std::chrono::steady_clock::now();
+        taskete::graph late{ exec };
+        taskete::graph early{ exec };
+        taskete::graph none{ exec };
+        late.emplace([&order] { order.push_back('L'); });
+        early.emplace([&order] { order.push_back('E'); });
+        none.emplace([&order] { order.push_back('N'); });
+        late.deadline(now + std::chrono::seconds(10));
+        early.deadline(now + std::chrono::seconds(1));
+
+        exec.submit(none);
+        exec.submit(late);
+        exec.submit(early);
+
+        go.store(true, std::memory_order_release);
+        exec.wait_idle();
+
+        REQUIRE((order == std::vector<char>{ 'E', 'L', 'N' }));
+    }
+
+    TEST_CASE("Graphs without a deadline don't starve")
+    {
+        auto opt = get_graph_options(1);
+        opt.deadline_burst = 2;
+
+        taskete::executor exec{ opt };
+        std::unique_ptr<taskete::graph> blocker;
+        std::atomic<bool> go{ false };
+        std::vector<char> order;
+
+        block_worker(exec, blocker, go);
+
+        taskete::graph none{ exec };
+        taskete::graph urgent{ exec };
+        none.emplace([&order] { order.push_back('N'); });
+        for (int i = 0; i < 6; ++i)
+            urgent.emplace([&order] { order.push_back('D'); });
+        urgent.deadline(std::chrono::steady_clock::now());
+
+        exec.submit(none);
+        exec.submit(urgent);
+
+        go.store(true, std::memory_order_release);
+        exec.wait_idle();
+
+        REQUIRE((order == std::vector<char>{ 'D', 'D', 'N', 'D', 'D', 'D', 'D' }));
+    }
+
+    TEST_CASE("A chain gives way to an earlier deadline")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph chain{ exec };
+        taskete::graph urgent{ exec };
+        std::vector<char> order;
+
+        urgent.emplace([&order] { order.push_back('U'); });
+        urgent.deadline(std::chrono::steady_clock::now());
+
+        auto a = chain.emplace([&exec, &urgent, &order]
+        {
+            order.push_back('a');
+            exec.submit(urgent);
+        });
+        auto b = chain.emplace([&order] { order.push_back('b'); });
+        chain.precede(a, b);
+
+        exec.submit(chain);
+        exec.wait_idle();
+
+        REQUIRE((order == std::vector<char>{ 'a', 'U', 'b' }));
+    }
+}
+
+TEST_SUITE("Graph - Affinity")
+{
+    taskete::executor_options get_affinity_options(std::chrono::microseconds grace) noexcept
+    {
+        auto opt = get_graph_options(2);
+        opt.affinity_grace = grace;
+        return opt;
+    }
+
+    TEST_CASE("A node follows its predecessor's worker")
+    {
+        taskete::executor exec{ get_affinity_options(std::chrono::seconds(1)) };
+        taskete::graph g{ exec };
+        std::thread::id producer, consumer;
+
+        // b is the continuation and keeps a's worker busy, the other worker could steal c without the hint
+        auto a = g.emplace([&producer] { producer = std::this_thread::get_id(); });
+        auto b = g.emplace([] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+        auto c = g.emplace([&consumer] { consumer = std::this_thread::get_id(); });
+        g.precede(a, b).precede(a, c).follow(c, a);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE((producer == consumer));
+    }
+
+    TEST_CASE("Roots run on their preferred worker")
+    {
+        taskete::executor exec{ get_affinity_options(std::chrono::seconds(1)) };
+        taskete::graph g{ exec };
+        std::vector<std::thread::id> threads(8);
+
+        for (std::size_t i = 0; i < threads.size(); ++i)
+            g.prefer_worker(g.emplace([&threads, i] { threads[i] = std::this_thread::get_id(); }), 1);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        for (auto const& id : threads)
+            REQUIRE((id == threads[0]));
+    }
+
+    TEST_CASE("A busy worker's nodes are stolen after the grace period")
+    {
+        taskete::executor exec{ get_affinity_options(std::chrono::milliseconds(1)) };
+        taskete::graph g{ exec };
+        std::atomic<bool> stolen{ false };
+
+        // b only ends once c ran, so c must be stolen from the worker running b
+        auto a = g.emplace([] {});
+        auto b = g.emplace([&stolen]
+        {
+            auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!stolen.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < until)
+                std::this_thread::yield();
+        });
+        auto c = g.emplace([&stolen] { stolen.store(true, std::memory_order_release); });
+        g.precede(a, b).precede(a, c).follow(c, a);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(stolen.load(std::memory_order_relaxed));
+    }
+}
+
+TEST_SUITE("Graph - Delays")
+{
+    TEST_CASE("A delayed node waits after its predecessors, without a worker")
+    {
+        using namespace std::chrono;
+
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        steady_clock::time_point released, started;
+        std::atomic<bool> other{ false };
+
+        auto a = g.emplace([&released] { released = steady_clock::now(); });
+        auto b = g.emplace([&started] { started = steady_clock::now(); });
+        auto c = g.emplace([&other] { other.store(true, std::memory_order_relaxed); });
+        g.precede(a, b).precede(a, c).delay(b, milliseconds(20));
+
+        exec.submit(g);
+        exec.wait(g);
+
+        // c ran on the only worker while b was waiting
+        REQUIRE(other.load(std::memory_order_relaxed));
+        REQUIRE(started - released >= milliseconds(20));
+    }
+
+    TEST_CASE("Delayed roots wait from the submission")
+    {
+        using namespace std::chrono;
+
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::vector<steady_clock::time_point> started(3);
+
+        for (std::size_t i = 0; i < started.size(); ++i)
+            g.delay(g.emplace([&started, i] { started[i] = steady_clock::now(); }), milliseconds(10 * (i + 1)));
+
+        auto submitted = steady_clock::now();
+        exec.submit(g);
+        exec.wait_idle();
+
+        for (std::size_t i = 0; i < started.size(); ++i)
+            REQUIRE(started[i] - submitted >= milliseconds(10 * (i + 1)));
+    }
+}
+
+TEST_SUITE("Graph - Cancellation")
+{
+    TEST_CASE("Nodes that didn't start are skipped, the graph still completes")
+    {
+        constexpr int chain_length = 100;
+
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<int> executed{ 0 };
+
+        auto prev = g.emplace([&g, &executed]
+        {
+            executed.fetch_add(1, std::memory_order_relaxed);
+            g.cancel();
+        });
+        for (int i = 1; i < chain_length; ++i)
+        {
+            auto next = g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+            g.precede(prev, next);
+            prev = next;
+        }
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(g.cancelled());
+        REQUIRE(executed.load(std::memory_order_relaxed) == 1);
+    }
+
+    TEST_CASE("A graph cancelled before its submission executes nothing")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        std::atomic<int> executed{ 0 };
+
+        auto a = g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+        auto b = g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+        g.precede(a, b).delay(b, std::chrono::seconds(10));
+        g.cancel();
+
+        auto start = std::chrono::steady_clock::now();
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == 0);
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    }
+
+    TEST_CASE("Delayed nodes already waiting don't hold a cancelled graph")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<int> executed{ 0 };
+        std::atomic<bool> delayed{ false };
+
+        auto a = g.emplace([&delayed] { delayed.store(true, std::memory_order_release); });
+        auto b = g.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+        g.precede(a, b).delay(b, std::chrono::seconds(10));
+
+        auto start = std::chrono::steady_clock::now();
+        exec.submit(g);
+        while (!delayed.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        g.cancel();
+        exec.wait(g);
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == 0);
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    }
+
+    TEST_CASE("Running nodes can stop early")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<bool> started{ false };
+
+        g.emplace([&g, &started]
+        {
+            started.store(true, std::memory_order_release);
+            while (!g.cancelled())
+                std::this_thread::yield();
+        });
+
+        exec.submit(g);
+        while (!started.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        g.cancel();
+        exec.wait(g);
+
+        REQUIRE(g.cancelled());
+    }
+}
+
+TEST_SUITE("Graph - Critical Path")
+{
+    // A root with many cheap successors, and a long chain declared last
+    void make_fan_out_with_chain(taskete::graph& g, std::vector<int>& order, int fan_out, int chain_length)
+    {
+        auto root = g.emplace([&order] { order.push_back(-1); });
+
+        for (int i = 0; i < fan_out; ++i)
+            g.precede(root, g.emplace([&order] { order.push_back(0); }));
+
+        auto prev = root;
+        for (int i = 0; i < chain_length; ++i)
+        {
+            auto next = g.emplace([&order] { order.push_back(1); });
+            g.precede(prev, next);
+            prev = next;
+        }
+    }
+
+    TEST_CASE("The longest path is dispatched first")
+    {
+        constexpr int fan_out = 10;
+        constexpr int chain_length = 5;
+
+        taskete::executor exec{ get_graph_options(1, taskete::scheduling_mode::critical_path) };
+        taskete::graph g{ exec };
+        std::vector<int> order;
+
+        make_fan_out_with_chain(g, order, fan_out, chain_length);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(order.size() == 1 + fan_out + chain_length);
+        REQUIRE(order[0] == -1);
+        for (int i = 1; i <= chain_length; ++i)
+            REQUIRE(order[i] == 1);
+    }
+
+    TEST_CASE("A node released earlier runs before the cheaper nodes released after it")
+    {
+        taskete::executor exec{ get_graph_options(1, taskete::scheduling_mode::critical_path) };
+        taskete::graph g{ exec };
+        std::vector<int> order;
+
+        // root -> heavy -> {leaf, leaf, leaf}
+        // root -> medium
+        auto root = g.emplace([&order] { order.push_back(0); });
+        auto heavy = g.emplace([&order] { order.push_back(1); });
+        auto medium = g.emplace([&order] { order.push_back(2); });
+        g.precede(root, medium).precede(root, heavy);
+        for (int i = 0; i < 3; ++i)
+            g.precede(heavy, g.emplace([&order] { order.push_back(3); }));
+        g.weight(heavy, 10).weight(medium, 5);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        // medium was released with heavy, before the leaves, but it still beats them
+        REQUIRE(order == std::vector<int>{ 0, 1, 2, 3, 3, 3 });
+    }
+
+    TEST_CASE("Without critical path, successors are released in declaration order")
+    {
+        constexpr int fan_out = 10;
+        constexpr int chain_length = 5;
+
+        taskete::executor exec{ get_graph_options(1) };
+        taskete::graph g{ exec };
+        std::vector<int> order;
+
+        make_fan_out_with_chain(g, order, fan_out, chain_length);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(order.size() == 1 + fan_out + chain_length);
+        REQUIRE(order[1] == 0);
+    }
+
+    TEST_CASE("Weights change the critical path")
+    {
+        taskete::executor exec{ get_graph_options(1, taskete::scheduling_mode::critical_path) };
+        taskete::graph g{ exec };
+        std::vector<int> order;
+
+        // root -> heavy
+        // root -> light1 -> light2
+        auto root = g.emplace([&order] { order.push_back(0); });
+        auto light1 = g.emplace([&order] { order.push_back(1); });
+        auto light2 = g.emplace([&order] { order.push_back(2); });
+        auto heavy = g.emplace([&order] { order.push_back(3); });
+
+        g.precede(root, light1).precede(light1, light2).precede(root, heavy);
+        g.weight(heavy, 10);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(order == std::vector<int>{ 0, 3, 1, 2 });
+    }
+}
+
+TEST_SUITE("Graph - Concurrency Caps")
+{
+    // Tracks how many nodes of the same graph run at the same time
+    struct concurrency_probe
+    {
+        std::atomic<int> running{ 0 };
+        std::atomic<int> peak{ 0 };
+        std::atomic<int> executed{ 0 };
+
+        void enter() noexcept
+        {
+            auto now = running.fetch_add(1, std::memory_order_seq_cst) + 1;
+            auto old = peak.load(std::memory_order_seq_cst);
+            while (now > old && !peak.compare_exchange_weak(old, now, std::memory_order_seq_cst));
+        }
+
+        void leave() noexcept
+        {
+            running.fetch_sub(1, std::memory_order_seq_cst);
+            executed.fetch_add(1, std::memory_order_seq_cst);
+        }
+    };
+
+    // Measures only while 'measuring' is set, the last node of the graph can reset it
+    void make_wide_graph(taskete::graph& g, concurrency_probe& probe, int width, std::atomic<bool>& measuring, bool reset_when_done = false)
+    {
+        for (int i = 0; i < width; ++i)
+            g.emplace([&probe, &measuring, width, reset_when_done]
+            {
+                bool measured = measuring.load(std::memory_order_seq_cst);
+                if (measured)
+                    probe.enter();
+
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+
+                if (measured)
+                    probe.leave();
+                else
+                    probe.executed.fetch_add(1, std::memory_order_seq_cst);
+
+                // Still inside the node, so before the graph's share is given back
+                if (reset_when_done && probe.executed.load(std::memory_order_seq_cst) == width)
+                    measuring.store(false, std::memory_order_seq_cst);
+            });
+    }
+
+    TEST_CASE("A graph never exceeds its worker cap")
+    {
+        constexpr int width = 64;
+
+        taskete::executor exec{ get_graph_options(4) };
+        taskete::graph g{ exec };
+        concurrency_probe probe;
+        std::atomic<bool> measuring{ true };
+
+        make_wide_graph(g, probe, width, measuring);
+        g.max_workers(2);
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(probe.executed.load(std::memory_order_relaxed) == width);
+        REQUIRE(probe.peak.load(std::memory_order_relaxed) <= 2);
+    }
+
+    TEST_CASE("Active graphs share the workers")
+    {
+        constexpr int width = 64;
+
+        auto options = get_graph_options(4);
+        options.fair_share = true;
+        taskete::executor exec{ options };
+
+        taskete::graph big{ exec };
+        taskete::graph small{ exec };
+        concurrency_probe big_probe, small_probe;
+        std::atomic<bool> measuring{ false };
+
+        // While the small graph runs, each one gets half of the workers
+        make_wide_graph(big, big_probe, width * 4, measuring);
+        make_wide_graph(small, small_probe, width, measuring, true);
+
+        exec.submit(big);
+        exec.submit(small);
+        measuring.store(true, std::memory_order_seq_cst);
+
+        exec.wait_idle();
+
+        REQUIRE(big_probe.executed.load(std::memory_order_relaxed) == width * 4);
+        REQUIRE(small_probe.peak.load(std::memory_order_relaxed) <= 2);
+        REQUIRE(big_probe.peak.load(std::memory_order_relaxed) <= 2);
+    }
+
+    TEST_CASE("A graph gets the workers back once the graphs sharing them completed")
+    {
+        constexpr int width = 400;
+
+        auto options = get_graph_options(4);
+        options.fair_share = true;
+        taskete::executor exec{ options };
+
+        taskete::graph big{ exec };
+        taskete::graph small{ exec };
+        concurrency_probe big_probe, small_probe;
+        std::atomic<bool> measuring{ false };
+        std::atomic<bool> alone{ false };
+
+        for (int i = 0; i < width; ++i)
+            big.emplace([&big_probe, &alone]
+            {
+                bool measured = alone.load(std::memory_order_seq_cst);
+                if (measured)
+                    big_probe.enter();
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+                if (measured)
+                    big_probe.leave();
+            });
+        make_wide_graph(small, small_probe, 16, measuring);
+
+        exec.submit(big);
+        exec.submit(small);
+        exec.wait(small);
+        alone.store(true, std::memory_order_seq_cst);
+
+        exec.wait(big);
+
+        REQUIRE(small_probe.executed.load(std::memory_order_relaxed) == 16);
+        REQUIRE(big_probe.peak.load(std::memory_order_relaxed) == 4);
+    }
+}
+
+TEST_SUITE("Graph - Dependencies")
+{
+    TEST_CASE("A graph starts only once the graph it starts after completed")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+
+        std::atomic<int> step{ 0 };
+        int seen_by_b = -1;
+
+        taskete::graph a{ exec };
+        auto first = a.emplace([&step]
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            step.fetch_add(1, std::memory_order_relaxed);
+        });
+        auto second = a.emplace([&step] { step.fetch_add(1, std::memory_order_relaxed); });
+        a.precede(first, second);
+
+        taskete::graph b{ exec };
+        b.emplace([&step, &seen_by_b] { seen_by_b = step.load(std::memory_order_relaxed); });
+        b.start_after(a);
+
+        exec.submit(a);
+        exec.submit(b);
+        exec.wait(b);
+
+        REQUIRE(seen_by_b == 2);
+        exec.wait(a);
+    }
+
+    TEST_CASE("A graph can start after a node, before the other graph completes")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+
+        std::atomic<bool> b_ran{ false };
+        bool a_saw_b = false;
+
+        taskete::graph a{ exec };
+        auto first = a.emplace([] {});
+        auto last = a.emplace([&b_ran, &a_saw_b]
+        {
+            auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!b_ran.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < give_up)
+                std::this_thread::yield();
+            a_saw_b = b_ran.load(std::memory_order_acquire);
+        });
+        a.precede(first, last);
+
+        taskete::graph b{ exec };
+        b.emplace([&b_ran] { b_ran.store(true, std::memory_order_release); });
+        b.start_after(a, first);
+
+        exec.submit(a);
+        exec.submit(b);
+        exec.wait(a);
+        exec.wait(b);
+
+        REQUIRE(a_saw_b);
+    }
+
+    TEST_CASE("Chained graphs run in order, every time they're submitted")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+
+        std::vector<int> order;
+
+        taskete::graph a{ exec };
+        a.emplace([&order] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); order.push_back(0); });
+        taskete::graph b{ exec };
+        b.emplace([&order] { order.push_back(1); });
+        taskete::graph c{ exec };
+        c.emplace([&order] { order.push_back(2); });
+
+        b.start_after(a);
+        c.start_after(b);
+
+        for (int run = 0; run < 2; ++run)
+        {
+            exec.submit(a);
+            exec.submit(b);
+            exec.submit(c);
+            exec.wait(c);
+            exec.wait(b);
+            exec.wait(a);
+        }
+
+        REQUIRE(order == std::vector<int>{ 0, 1, 2, 0, 1, 2 });
+    }
+
+    TEST_CASE("A graph cancelled while it waits for another one doesn't run")
+    {
+        taskete::executor exec{ get_graph_options(2) };
+
+        std::atomic<bool> go{ false };
+        std::atomic<int> executed{ 0 };
+
+        taskete::graph a{ exec };
+        a.emplace([&go]
+        {
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        });
+
+        taskete::graph b{ exec };
+        b.emplace([&executed] { executed.fetch_add(1, std::memory_order_relaxed); });
+        b.start_after(a);
+
+        exec.submit(a);
+        exec.submit(b);
+        b.cancel();
+        go.store(true, std::memory_order_release);
+
+        exec.wait(b);
+        exec.wait(a);
+
+        REQUIRE(executed.load(std::memory_order_relaxed) == 0);
+        REQUIRE(b.cancelled());
+    }
+
+    TEST_CASE("A completed graph doesn't hold anybody, a graph never submitted can't be waited for")
+    {
+        taskete::executor exec{ get_graph_options(1) };
+
+        taskete::graph a{ exec };
+        auto node = a.emplace([] {});
+        exec.submit(a);
+        exec.wait(a);
+
+        bool ran = false;
+        taskete::graph b{ exec };
+        b.emplace([&ran] { ran = true; });
+        b.start_after(a, node);
+        exec.submit(b);
+        exec.wait(b);
+        REQUIRE(ran);
+
+        taskete::graph never{ exec };
+        never.emplace([] {});
+        taskete::graph c{ exec };
+        c.emplace([] {});
+        c.start_after(never);
+        REQUIRE_THROWS_AS(exec.submit(c), std::logic_error);
+    }
+}
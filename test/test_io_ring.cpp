@@ -0,0 +1,229 @@
+#include "../source/taskete/graph.hpp"
+#include "../source/taskete/io_ring.hpp"
+
+#include <doctest.h>
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    taskete::executor_options get_io_options(std::uint32_t workers) noexcept
+    {
+        taskete::executor_options opt{};
+        opt.worker_count = workers;
+        opt.queue_capacity = 64;
+        opt.node_pool.pool_capacity = 64;
+        opt.io_queue_depth = 8;
+        return opt;
+    }
+
+    // Unlinked right away, it goes away with its descriptor
+    int make_temp_file()
+    {
+        char path[] = "/tmp/taskete_test_io_XXXXXX";
+        int fd = mkstemp(path);
+        unlink(path);
+        return fd;
+    }
+
+    bool io_uring_available() noexcept
+    {
+        taskete::detail::io_ring ring;
+        return ring.open(1);
+    }
+}
+
+TEST_SUITE("I/O Ring")
+{
+    TEST_CASE("Requests complete through the ring")
+    {
+        taskete::detail::io_ring ring;
+        if (!ring.open(4))
+            return; // e.g. forbidden by seccomp
+
+        int fd = make_temp_file();
+        REQUIRE(fd >= 0);
+
+        char data[] = "taskete";
+        taskete::io_request write{ taskete::io_op::write, fd, data, sizeof(data), 0 };
+        REQUIRE(ring.submit(write, 42));
+
+        taskete::detail::io_completion completion{};
+        REQUIRE(ring.wait(&completion, 1) == 1);
+        REQUIRE(completion.user_data == 42);
+        REQUIRE(completion.result == sizeof(data));
+
+        REQUIRE(ring.stop());
+        REQUIRE(ring.wait(&completion, 1) == 1);
+        REQUIRE(completion.user_data == taskete::detail::io_ring::stop_marker);
+
+        close(fd);
+    }
+
+    TEST_CASE("No more requests are in flight than the completion queue holds")
+    {
+        taskete::detail::io_ring ring;
+        if (!ring.open(1))
+            return;
+
+        int fd = make_temp_file();
+        REQUIRE(fd >= 0);
+
+        // 1 submission entry, 2 completion entries
+        taskete::io_request sync{ taskete::io_op::fsync, fd };
+        REQUIRE(ring.submit(sync, 1));
+        REQUIRE(ring.submit(sync, 2));
+        REQUIRE_FALSE(ring.submit(sync, 3));
+
+        taskete::detail::io_completion completions[2]{};
+        auto reaped = ring.wait(completions, 2);
+        if (reaped == 1)
+            reaped += ring.wait(completions + 1, 1);
+        REQUIRE(reaped == 2);
+
+        REQUIRE(ring.submit(sync, 3));
+        REQUIRE(ring.wait(completions, 1) == 1);
+        REQUIRE(completions[0].user_data == 3);
+
+        close(fd);
+    }
+
+    TEST_CASE("A stop the ring refused still ends the wait")
+    {
+        taskete::detail::io_ring ring;
+        if (!ring.open(1))
+            return;
+
+        int fd = make_temp_file();
+        REQUIRE(fd >= 0);
+
+        // The completion queue is full of requests in flight, there's no room for the marker
+        taskete::io_request sync{ taskete::io_op::fsync, fd };
+        REQUIRE(ring.submit(sync, 1));
+        REQUIRE(ring.submit(sync, 2));
+        REQUIRE_FALSE(ring.stop());
+
+        taskete::detail::io_completion completions[2]{};
+        std::uint32_t reaped = 0;
+        while (reaped < 2)
+        {
+            auto count = ring.wait(completions, 2);
+            REQUIRE(count > 0);
+            reaped += count;
+        }
+
+        REQUIRE(ring.wait(completions, 2) == 0);
+
+        close(fd);
+    }
+
+    TEST_CASE("Requests can be executed synchronously")
+    {
+        int fd = make_temp_file();
+        REQUIRE(fd >= 0);
+
+        char data[] = "taskete";
+        char buffer[sizeof(data)]{};
+        REQUIRE(taskete::detail::io_ring::perform({ taskete::io_op::write, fd, data, sizeof(data), 0 }) == sizeof(data));
+        REQUIRE(taskete::detail::io_ring::perform({ taskete::io_op::fsync, fd }) == 0);
+        REQUIRE(taskete::detail::io_ring::perform({ taskete::io_op::read, fd, buffer, sizeof(buffer), 0 }) == sizeof(data));
+        REQUIRE(std::strcmp(buffer, data) == 0);
+
+        REQUIRE(taskete::detail::io_ring::perform({ taskete::io_op::read, -1, buffer, sizeof(buffer), 0 }) == -EBADF);
+
+        close(fd);
+    }
+}
+
+TEST_SUITE("Graph - I/O")
+{
+    TEST_CASE("Successors see the result of the request")
+    {
+        taskete::executor exec{ get_io_options(2) };
+        taskete::graph g{ exec };
+
+        int fd = make_temp_file();
+        REQUIRE(fd >= 0);
+
+        char data[] = "taskete";
+        char buffer[sizeof(data)]{};
+        taskete::io_request write{ taskete::io_op::write, fd, data, sizeof(data), 0 };
+        taskete::io_request sync{ taskete::io_op::fdatasync, fd };
+        taskete::io_request read{ taskete::io_op::read, fd, buffer, sizeof(buffer), 0 };
+        std::string seen;
+
+        auto w = g.emplace_io(write);
+        auto s = g.emplace_io(sync);
+        auto r = g.emplace_io(read);
+        auto check = g.emplace([&seen, &buffer] { seen = buffer; });
+        g.precede(w, s).precede(s, r).precede(r, check);
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(write.result == sizeof(data));
+        REQUIRE(sync.result == 0);
+        REQUIRE(read.result == sizeof(data));
+        REQUIRE(seen == data);
+
+        close(fd);
+    }
+
+    TEST_CASE("Failures are reported in the request")
+    {
+        taskete::executor exec{ get_io_options(1) };
+        taskete::graph g{ exec };
+
+        char buffer[8]{};
+        taskete::io_request read{ taskete::io_op::read, -1, buffer, sizeof(buffer), 0 };
+        std::int32_t seen = 0;
+
+        auto r = g.emplace_io(read);
+        g.precede(r, g.emplace([&seen, &read] { seen = read.result; }));
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(seen == -EBADF);
+    }
+
+    TEST_CASE("Pending I/O doesn't block the worker")
+    {
+        if (!io_uring_available())
+            return;
+
+        // The only worker must run the writer while the read is pending, or nobody ever writes
+        taskete::executor exec{ get_io_options(1) };
+        taskete::graph g{ exec };
+
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+
+        char data[] = "taskete";
+        char buffer[sizeof(data)]{};
+        taskete::io_request read{ taskete::io_op::read, fds[0], buffer, sizeof(buffer), 0 };
+
+        g.emplace_io(read);
+        g.emplace([fd = fds[1], &data] { (void)!::write(fd, data, sizeof(data)); });
+
+        exec.submit(g);
+        exec.wait_idle();
+
+        REQUIRE(read.result == sizeof(data));
+        REQUIRE(std::strcmp(buffer, data) == 0);
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+#endif
@@ -0,0 +1,300 @@
+#include "../source/taskete/parallel.hpp"
+
+#include <doctest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    taskete::executor_options get_parallel_options(std::uint32_t workers) noexcept
+    {
+        taskete::executor_options opt{};
+        opt.worker_count = workers;
+        opt.queue_capacity = 64;
+        opt.node_pool.pool_capacity = 256;
+        return opt;
+    }
+}
+
+TEST_SUITE("Parallel - For")
+{
+    TEST_CASE("Every index is visited exactly once")
+    {
+        constexpr std::size_t n = 100000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+        std::vector<std::atomic<int>> visits(n);
+        std::atomic<std::size_t> longest{ 0 };
+
+        taskete::parallel_for(exec, taskete::blocked_range<std::size_t>{ 0, n }, std::size_t(64), [&visits, &longest](std::size_t first, std::size_t last)
+        {
+            auto length = last - first;
+            auto seen = longest.load(std::memory_order_relaxed);
+            while (length > seen && !longest.compare_exchange_weak(seen, length, std::memory_order_relaxed))
+                ;
+
+            for (auto i = first; i < last; ++i)
+                visits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+
+        REQUIRE(longest.load(std::memory_order_relaxed) <= 64);
+        for (auto& v : visits)
+            REQUIRE(v.load(std::memory_order_relaxed) == 1);
+    }
+
+    TEST_CASE("Uneven costs are split among the workers")
+    {
+        constexpr int n = 256;
+
+        taskete::executor exec{ get_parallel_options(2) };
+        std::atomic<int> visited{ 0 };
+
+        // The last indices are much more expensive
+        taskete::parallel_for(exec, taskete::blocked_range<int>{ 0, n }, 4, [&visited](int first, int last)
+        {
+            for (int i = first; i < last; ++i)
+            {
+                if (i >= n - 16)
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                visited.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        REQUIRE(visited.load(std::memory_order_relaxed) == n);
+    }
+
+    TEST_CASE("Can be nested inside a node")
+    {
+        taskete::executor exec{ get_parallel_options(2) };
+        taskete::graph g{ exec };
+        std::atomic<int> visited{ 0 };
+
+        g.emplace([&exec, &visited]
+        {
+            taskete::parallel_for(exec, taskete::blocked_range<int>{ 0, 1000 }, 10, [&visited](int first, int last)
+            {
+                visited.fetch_add(last - first, std::memory_order_relaxed);
+            });
+        });
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(visited.load(std::memory_order_relaxed) == 1000);
+    }
+
+    TEST_CASE("Empty and small ranges")
+    {
+        taskete::executor exec{ get_parallel_options(1) };
+        int calls = 0;
+
+        taskete::parallel_for(exec, taskete::blocked_range<int>{ 5, 5 }, 1, [&calls](int, int) { ++calls; });
+        REQUIRE(calls == 0);
+
+        taskete::parallel_for(exec, taskete::blocked_range<int>{ 0, 3 }, 8, [&calls](int first, int last)
+        {
+            REQUIRE(first == 0);
+            REQUIRE(last == 3);
+            ++calls;
+        });
+        REQUIRE(calls == 1);
+    }
+}
+
+TEST_SUITE("Parallel - Reduce")
+{
+    TEST_CASE("Sums a range")
+    {
+        constexpr std::uint64_t n = 1000000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        auto sum = taskete::parallel_reduce(exec, taskete::blocked_range<std::uint64_t>{ 0, n }, std::uint64_t(1000), std::uint64_t(0),
+            [](std::uint64_t first, std::uint64_t last, std::uint64_t acc)
+            {
+                for (auto i = first; i < last; ++i)
+                    acc += i;
+                return acc;
+            },
+            [](std::uint64_t lhs, std::uint64_t rhs) { return lhs + rhs; });
+
+        REQUIRE(sum == n * (n - 1) / 2);
+    }
+
+    TEST_CASE("Results are combined in the order of the indices")
+    {
+        constexpr int n = 2000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        std::string expected;
+        for (int i = 0; i < n; ++i)
+            expected += char('a' + i % 26);
+
+        auto joined = taskete::parallel_reduce(exec, taskete::blocked_range<int>{ 0, n }, 7, std::string{},
+            [](int first, int last, std::string acc)
+            {
+                for (int i = first; i < last; ++i)
+                    acc += char('a' + i % 26);
+                return acc;
+            },
+            [](std::string lhs, std::string const& rhs) { return lhs + rhs; });
+
+        REQUIRE(joined == expected);
+    }
+
+    TEST_CASE("An empty range reduces to the identity")
+    {
+        taskete::executor exec{ get_parallel_options(1) };
+
+        auto result = taskete::parallel_reduce(exec, taskete::blocked_range<int>{ 3, 0 }, 1, 42,
+            [](int, int, int acc) { return acc + 1; },
+            [](int lhs, int rhs) { return lhs + rhs; });
+
+        REQUIRE(result == 42);
+    }
+}
+
+TEST_SUITE("Parallel - Scan")
+{
+    TEST_CASE("Inclusive scan matches std::inclusive_scan")
+    {
+        constexpr std::size_t n = 100000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        std::vector<std::uint64_t> values(n);
+        for (std::size_t i = 0; i < n; ++i)
+            values[i] = i * 7 % 13;
+
+        std::vector<std::uint64_t> expected(n);
+        std::inclusive_scan(values.begin(), values.end(), expected.begin());
+
+        std::vector<std::uint64_t> result(n);
+        auto end = taskete::parallel_inclusive_scan(exec, values.begin(), values.end(), result.begin(), std::plus<>{}, 1000);
+
+        REQUIRE(end == result.end());
+        REQUIRE(result == expected);
+    }
+
+    TEST_CASE("Exclusive scan starts from init")
+    {
+        constexpr std::size_t n = 50000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        std::vector<std::uint64_t> values(n, 1);
+        std::vector<std::uint64_t> result(n);
+        taskete::parallel_exclusive_scan(exec, values.begin(), values.end(), result.begin(), std::uint64_t(10), std::plus<>{}, 1000);
+
+        for (std::size_t i = 0; i < n; ++i)
+            REQUIRE(result[i] == 10 + i);
+    }
+
+    TEST_CASE("Scans in place and keeps the order of a non-commutative operation")
+    {
+        constexpr int n = 3000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        std::vector<std::string> values(n);
+        for (int i = 0; i < n; ++i)
+            values[std::size_t(i)] = char('a' + i % 26);
+
+        std::vector<std::string> expected(n);
+        std::inclusive_scan(values.begin(), values.end(), expected.begin(), std::plus<>{});
+
+        taskete::parallel_inclusive_scan(exec, values.begin(), values.end(), values.begin(), std::plus<>{}, 100);
+
+        REQUIRE(values == expected);
+    }
+
+    TEST_CASE("Small ranges are scanned inline")
+    {
+        taskete::executor exec{ get_parallel_options(1) };
+
+        std::vector<int> values{ 1, 2, 3, 4 };
+        std::vector<int> result(4);
+        taskete::parallel_exclusive_scan(exec, values.begin(), values.end(), result.begin(), 0, std::plus<>{});
+
+        REQUIRE(result == std::vector<int>{ 0, 1, 3, 6 });
+
+        std::vector<int> empty;
+        REQUIRE(taskete::parallel_inclusive_scan(exec, empty.begin(), empty.end(), result.begin(), std::plus<>{}, 0) == result.begin());
+    }
+}
+
+TEST_SUITE("Parallel - Sort")
+{
+    TEST_CASE("Sorts like std::sort")
+    {
+        constexpr std::size_t n = 200000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        std::mt19937 rng{ 42 };
+        std::vector<std::uint32_t> values(n);
+        for (auto& value : values)
+            value = rng();
+
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+
+        taskete::parallel_sort(exec, values.begin(), values.end(), std::less<>{}, 1000);
+
+        REQUIRE(values == expected);
+    }
+
+    TEST_CASE("Sorts many duplicates with a custom comparison")
+    {
+        constexpr std::size_t n = 100000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        std::vector<int> values(n);
+        for (std::size_t i = 0; i < n; ++i)
+            values[i] = int(i * 7919 % 3);
+
+        auto expected = values;
+        std::sort(expected.begin(), expected.end(), std::greater<>{});
+
+        taskete::parallel_sort(exec, values.begin(), values.end(), std::greater<>{}, 500);
+
+        REQUIRE(values == expected);
+    }
+
+    TEST_CASE("Sorts move-only elements")
+    {
+        constexpr int n = 20000;
+
+        taskete::executor exec{ get_parallel_options(2) };
+
+        std::vector<std::unique_ptr<int>> values;
+        for (int i = 0; i < n; ++i)
+            values.push_back(std::make_unique<int>(i * 37 % n));
+
+        taskete::parallel_sort(exec, values.begin(), values.end(), [](auto const& lhs, auto const& rhs) { return *lhs < *rhs; }, 100);
+
+        for (int i = 0; i < n; ++i)
+            REQUIRE(*values[std::size_t(i)] == i);
+    }
+
+    TEST_CASE("Small ranges are sorted inline")
+    {
+        taskete::executor exec{ get_parallel_options(1) };
+
+        std::vector<int> values{ 3, 1, 2 };
+        taskete::parallel_sort(exec, values.begin(), values.end());
+
+        REQUIRE(values == std::vector<int>{ 1, 2, 3 });
+    }
+}
@@ -0,0 +1,173 @@
+#include "../source/taskete/pipeline.hpp"
+
+#include <doctest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    taskete::executor_options get_pipeline_options(std::uint32_t workers) noexcept
+    {
+        taskete::executor_options opt{};
+        opt.worker_count = workers;
+        opt.queue_capacity = 64;
+        opt.node_pool.pool_capacity = 256;
+        return opt;
+    }
+
+    struct record
+    {
+        int value = 0;
+        int doubled = 0;
+    };
+
+    void raise_max(std::atomic<int>& max, int value) noexcept
+    {
+        auto current = max.load(std::memory_order_relaxed);
+        while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            ;
+    }
+}
+
+TEST_SUITE("Pipeline")
+{
+    TEST_CASE("A serial in-order stage sees the items in the source's order")
+    {
+        constexpr int n = 5000;
+
+        taskete::executor exec{ get_pipeline_options(2) };
+
+        int next = 0;
+        std::vector<int> received;
+
+        taskete::pipeline<record> p{ 8 };
+        p.source([&next](record& r)
+        {
+            if (next == n)
+                return false;
+            r.value = next++;
+            return true;
+        })
+        .stage(taskete::stage_mode::parallel, [](record& r) { r.doubled = r.value * 2; })
+        .stage(taskete::stage_mode::serial_in_order, [&received](record& r) { received.push_back(r.doubled); });
+
+        p.run(exec);
+
+        REQUIRE(received.size() == std::size_t(n));
+        for (int i = 0; i < n; ++i)
+            REQUIRE(received[std::size_t(i)] == i * 2);
+    }
+
+    TEST_CASE("No more items than tokens are in flight")
+    {
+        constexpr int n = 2000;
+        constexpr std::uint32_t tokens = 4;
+
+        taskete::executor exec{ get_pipeline_options(2) };
+
+        int made = 0;
+        std::atomic<int> in_flight{ 0 };
+        std::atomic<int> max_in_flight{ 0 };
+        std::atomic<int> done{ 0 };
+
+        taskete::pipeline<record> p{ tokens };
+        p.source([&made, &in_flight, &max_in_flight](record& r)
+        {
+            if (made == n)
+                return false;
+            r.value = made++;
+            raise_max(max_in_flight, in_flight.fetch_add(1, std::memory_order_relaxed) + 1);
+            return true;
+        })
+        .stage(taskete::stage_mode::parallel, [](record& r) { r.doubled = r.value * 2; })
+        .stage(taskete::stage_mode::serial_out_of_order, [&in_flight, &done](record&)
+        {
+            done.fetch_add(1, std::memory_order_relaxed);
+            in_flight.fetch_sub(1, std::memory_order_relaxed);
+        });
+
+        p.run(exec);
+
+        REQUIRE(done.load() == n);
+        REQUIRE(max_in_flight.load() <= int(tokens));
+    }
+
+    TEST_CASE("Serial stages run one item at a time")
+    {
+        constexpr int n = 3000;
+
+        taskete::executor exec{ get_pipeline_options(2) };
+
+        int made = 0;
+        std::atomic<int> inside{ 0 };
+        std::atomic<int> max_inside{ 0 };
+        std::int64_t sum = 0;
+
+        taskete::pipeline<record> p{ 16 };
+        p.source([&made](record& r)
+        {
+            if (made == n)
+                return false;
+            r.value = made++;
+            return true;
+        })
+        .stage(taskete::stage_mode::parallel, [](record& r) { r.doubled = r.value * 2; })
+        .stage(taskete::stage_mode::serial_out_of_order, [&inside, &max_inside, &sum](record& r)
+        {
+            raise_max(max_inside, inside.fetch_add(1, std::memory_order_relaxed) + 1);
+            sum += r.doubled;
+            inside.fetch_sub(1, std::memory_order_relaxed);
+        })
+        .stage(taskete::stage_mode::parallel, [](record&) {});
+
+        p.run(exec);
+
+        REQUIRE(max_inside.load() == 1);
+        REQUIRE(sum == std::int64_t(n) * (n - 1));
+    }
+
+    TEST_CASE("A pipeline can run again, from a node")
+    {
+        taskete::executor exec{ get_pipeline_options(2) };
+
+        int remaining = 0;
+        int total = 0;
+
+        taskete::pipeline<record> p{ 2 };
+        p.source([&remaining](record& r)
+        {
+            r.value = 1;
+            return remaining-- > 0;
+        })
+        .stage(taskete::stage_mode::serial_in_order, [&total](record& r) { total += r.value; });
+
+        remaining = 10;
+        p.run(exec);
+        REQUIRE(total == 10);
+
+        taskete::graph g{ exec };
+        g.emplace([&exec, &p, &remaining]
+        {
+            remaining = 5;
+            p.run(exec);
+        });
+
+        exec.submit(g);
+        exec.wait(g);
+
+        REQUIRE(total == 15);
+    }
+
+    TEST_CASE("Running without a source throws")
+    {
+        taskete::executor exec{ get_pipeline_options(1) };
+
+        taskete::pipeline<record> p{ 2 };
+        p.stage(taskete::stage_mode::parallel, [](record&) {});
+
+        REQUIRE_THROWS_AS(p.run(exec), std::logic_error);
+    }
+}
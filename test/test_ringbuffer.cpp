@@ -182,3 +182,58 @@ TEST_SUITE("Ringbuffer - 1P1C - Multithread")
         producer.join();
     }
 }
+
+TEST_SUITE("Ringbuffer - Bulk - Single Thread")
+{
+    using taskete::detail::lockfree_ringbuffer;
+
+    constexpr std::uint32_t ring_size = 8;
+
+    TEST_CASE("Bulk push keeps the order")
+    {
+        lockfree_ringbuffer<int> ring(std::pmr::get_default_resource(), ring_size);
+        int elems[] = { 1, 2, 3, 4, 5 };
+
+        REQUIRE(ring.try_push_bulk(elems, 5) == 5);
+        REQUIRE(ring.free_space() == ring_size - 5);
+
+        int elem = -1;
+        for (int expected : elems)
+        {
+            REQUIRE(ring.try_pull(elem));
+            REQUIRE(elem == expected);
+        }
+
+        REQUIRE(ring.empty());
+        REQUIRE(ring.free_space() == ring_size);
+    }
+
+    TEST_CASE("Bulk push stops when the buffer is full")
+    {
+        lockfree_ringbuffer<int> ring(std::pmr::get_default_resource(), ring_size);
+        int elems[ring_size * 2] = {};
+
+        REQUIRE(ring.try_push(0));
+        REQUIRE(ring.try_push_bulk(elems, ring_size * 2) == ring_size - 1);
+        REQUIRE(ring.try_push_bulk(elems, 1) == 0);
+        REQUIRE_FALSE(ring.try_push(0));
+        REQUIRE(ring.free_space() == 0);
+    }
+
+    TEST_CASE("Bulk push wraps around the buffer")
+    {
+        lockfree_ringbuffer<int> ring(std::pmr::get_default_resource(), ring_size);
+        int elems[] = { 0, 1, 2, 3, 4, 5 };
+        int elem = -1;
+
+        for (int round = 0; round < 4; ++round)
+        {
+            REQUIRE(ring.try_push_bulk(elems, 6) == 6);
+            for (int expected : elems)
+            {
+                REQUIRE(ring.try_pull(elem));
+                REQUIRE(elem == expected);
+            }
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#include "../source/taskete/timing_wheel.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace
+{
+    // Advances one tick at a time, and records when each entry expired
+    std::vector<std::int64_t> expire_all(taskete::detail::timing_wheel& wheel, std::size_t entries, std::int64_t until)
+    {
+        std::vector<std::int64_t> expired_at(entries, -1);
+        std::pmr::vector<std::uint64_t> expired(std::pmr::get_default_resource());
+
+        while (wheel.current() < until && !wheel.empty())
+        {
+            wheel.advance(wheel.current() + 1, expired);
+            for (auto data : expired)
+                expired_at[data] = wheel.current();
+            expired.clear();
+        }
+
+        return expired_at;
+    }
+}
+
+TEST_SUITE("Timing Wheel")
+{
+    using taskete::detail::timing_wheel;
+
+    TEST_CASE("Entries expire exactly when they are due, on every level")
+    {
+        constexpr std::int64_t start = 1000;
+        timing_wheel wheel{ std::pmr::get_default_resource(), start };
+
+        std::vector<std::int64_t> delays{ 1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 100000, 262144, 262145 };
+        for (std::size_t i = 0; i < delays.size(); ++i)
+            wheel.schedule(start + delays[i], i);
+
+        REQUIRE(wheel.size() == delays.size());
+
+        auto expired_at = expire_all(wheel, delays.size(), start + 300000);
+
+        for (std::size_t i = 0; i < delays.size(); ++i)
+            REQUIRE(expired_at[i] == start + delays[i]);
+        REQUIRE(wheel.empty());
+    }
+
+    TEST_CASE("Entries beyond the last level are parked until they are due")
+    {
+        timing_wheel wheel{ std::pmr::get_default_resource(), 0 };
+        std::pmr::vector<std::uint64_t> expired(std::pmr::get_default_resource());
+
+        constexpr std::int64_t due = (std::int64_t(1) << 24) + 12345;
+        wheel.schedule(due, 7);
+
+        wheel.advance(due - 1, expired);
+        REQUIRE(expired.empty());
+        REQUIRE(wheel.size() == 1);
+
+        wheel.advance(due, expired);
+        REQUIRE((expired == std::pmr::vector<std::uint64_t>{ 7 }));
+    }
+
+    TEST_CASE("Entries already due expire at the next tick")
+    {
+        timing_wheel wheel{ std::pmr::get_default_resource(), 50 };
+        std::pmr::vector<std::uint64_t> expired(std::pmr::get_default_resource());
+
+        wheel.schedule(10, 1);
+        wheel.advance(51, expired);
+
+        REQUIRE((expired == std::pmr::vector<std::uint64_t>{ 1 }));
+    }
+
+    TEST_CASE("Advancing by many ticks at once expires everything on the way")
+    {
+        timing_wheel wheel{ std::pmr::get_default_resource(), 0 };
+        std::pmr::vector<std::uint64_t> expired(std::pmr::get_default_resource());
+
+        for (std::uint64_t i = 1; i <= 1000; ++i)
+            wheel.schedule(std::int64_t(i * 37), i);
+
+        wheel.advance(37 * 500, expired);
+        REQUIRE(expired.size() == 500);
+
+        wheel.advance(37 * 1000, expired);
+        REQUIRE(expired.size() == 1000);
+        REQUIRE(wheel.empty());
+    }
+
+    TEST_CASE("The next expiry is never later than the earliest entry")
+    {
+        timing_wheel wheel{ std::pmr::get_default_resource(), 0 };
+
+        REQUIRE(wheel.next_expiry() == timing_wheel::no_expiry);
+
+        wheel.schedule(10, 0);
+        REQUIRE(wheel.next_expiry() == 10);
+
+        wheel.schedule(5000, 1);
+        REQUIRE(wheel.next_expiry() == 10);
+
+        std::pmr::vector<std::uint64_t> expired(std::pmr::get_default_resource());
+        wheel.advance(10, expired);
+        REQUIRE(wheel.next_expiry() == 64);
+        REQUIRE(wheel.next_expiry() <= 5000);
+    }
+
+    TEST_CASE("Draining removes every entry")
+    {
+        timing_wheel wheel{ std::pmr::get_default_resource(), 0 };
+        std::pmr::vector<std::uint64_t> entries(std::pmr::get_default_resource());
+
+        wheel.schedule(3, 0);
+        wheel.schedule(300, 1);
+        wheel.schedule(300000, 2);
+        wheel.drain(entries);
+
+        REQUIRE(entries.size() == 3);
+        REQUIRE(wheel.empty());
+    }
+
+    TEST_CASE("Extracting removes only the matching entries")
+    {
+        timing_wheel wheel{ std::pmr::get_default_resource(), 0 };
+        std::pmr::vector<std::uint64_t> entries(std::pmr::get_default_resource());
+
+        for (std::uint64_t i = 0; i < 6; ++i)
+            wheel.schedule(std::int64_t(3 + i * 100), i);
+        wheel.extract_if([](std::uint64_t data) { return data % 2 == 0; }, entries);
+
+        std::sort(entries.begin(), entries.end());
+        REQUIRE((entries == std::pmr::vector<std::uint64_t>{ 0, 2, 4 }));
+        REQUIRE(wheel.size() == 3);
+
+        auto expired_at = expire_all(wheel, 6, 1000);
+        REQUIRE(expired_at == std::vector<std::int64_t>{ -1, 103, -1, 303, -1, 503 });
+    }
+}
@@ -0,0 +1,180 @@
+#include "../source/taskete/work_stealing_deque.hpp"
+
+#include <doctest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("Work Stealing Deque - Single Thread")
+{
+    using taskete::detail::work_stealing_deque;
+
+    constexpr std::uint32_t deque_size = 8;
+
+    TEST_CASE("Just constructed deque is empty and has correct size")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), deque_size);
+
+        REQUIRE(deque.empty());
+        REQUIRE(deque.size() == deque_size);
+        REQUIRE(deque.count() == 0);
+    }
+
+    TEST_CASE("Size is rounded up to a power of 2")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), 5);
+
+        REQUIRE(deque.size() == 8);
+    }
+
+    TEST_CASE("A full deque prevents additional data to be pushed")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), deque_size);
+
+        for (int i = 0; i < int(deque_size); ++i)
+            REQUIRE(deque.try_push(i));
+
+        REQUIRE_FALSE(deque.try_push(-1));
+        REQUIRE(deque.count() == deque_size);
+    }
+
+    TEST_CASE("The owner pops the newest element")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), deque_size);
+
+        for (int i = 0; i < int(deque_size); ++i)
+            REQUIRE(deque.try_push(i));
+
+        int elem = -1;
+        for (int i = int(deque_size) - 1; i >= 0; --i)
+        {
+            REQUIRE(deque.try_pop(elem));
+            REQUIRE(elem == i);
+        }
+
+        REQUIRE_FALSE(deque.try_pop(elem));
+        REQUIRE(deque.empty());
+    }
+
+    TEST_CASE("Thieves steal the oldest element")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), deque_size);
+
+        for (int i = 0; i < int(deque_size); ++i)
+            REQUIRE(deque.try_push(i));
+
+        int elem = -1;
+        for (int i = 0; i < int(deque_size); ++i)
+        {
+            REQUIRE(deque.try_steal(elem));
+            REQUIRE(elem == i);
+        }
+
+        REQUIRE_FALSE(deque.try_steal(elem));
+        REQUIRE(deque.empty());
+    }
+
+    TEST_CASE("Bulk push stops when the deque is full")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), deque_size);
+        int elems[deque_size * 2];
+        for (int i = 0; i < int(deque_size) * 2; ++i)
+            elems[i] = i;
+
+        REQUIRE(deque.try_push(-1));
+        REQUIRE(deque.try_push_bulk(elems, deque_size * 2) == deque_size - 1);
+        REQUIRE(deque.try_push_bulk(elems, 1) == 0);
+
+        int elem = -2;
+        REQUIRE(deque.try_steal(elem));
+        REQUIRE(elem == -1);
+        REQUIRE(deque.try_pop(elem));
+        REQUIRE(elem == int(deque_size) - 2);
+    }
+
+    TEST_CASE("Indices wrap around the buffer")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), deque_size);
+
+        int elem = -1;
+        for (int round = 0; round < 5; ++round)
+        {
+            for (int i = 0; i < int(deque_size); ++i)
+                REQUIRE(deque.try_push(i));
+            for (int i = 0; i < int(deque_size); ++i)
+                REQUIRE(deque.try_steal(elem));
+        }
+
+        REQUIRE(deque.empty());
+    }
+}
+
+TEST_SUITE("Work Stealing Deque - 1 Owner N Thieves - Multithread")
+{
+    using taskete::detail::work_stealing_deque;
+
+    constexpr std::uint32_t deque_size = 64;
+    constexpr int element_count = 20000;
+    constexpr int thief_count = 3;
+
+    TEST_CASE("Every element is taken exactly once")
+    {
+        work_stealing_deque<int> deque(std::pmr::get_default_resource(), deque_size);
+
+        std::vector<std::atomic<int>> taken(element_count);
+        for (auto& t : taken)
+            t.store(0, std::memory_order_relaxed);
+
+        std::atomic<bool> done{ false };
+        std::atomic<int> total{ 0 };
+
+        std::vector<std::thread> thieves;
+        for (int i = 0; i < thief_count; ++i)
+        {
+            thieves.emplace_back([&]
+            {
+                int elem;
+                while (!done.load(std::memory_order_acquire))
+                {
+                    if (deque.try_steal(elem))
+                    {
+                        taken[elem].fetch_add(1, std::memory_order_relaxed);
+                        total.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        int elem;
+        for (int i = 0; i < element_count; ++i)
+        {
+            while (!deque.try_push(i))
+            {
+                if (deque.try_pop(elem))
+                {
+                    taken[elem].fetch_add(1, std::memory_order_relaxed);
+                    total.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        while (deque.try_pop(elem))
+        {
+            taken[elem].fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        while (total.load(std::memory_order_acquire) != element_count)
+            std::this_thread::yield();
+
+        done.store(true, std::memory_order_release);
+        for (auto& th : thieves)
+            th.join();
+
+        for (auto& t : taken)
+            REQUIRE(t.load(std::memory_order_relaxed) == 1);
+    }
+}